@@ -26,6 +26,9 @@ public class InputSettingsRuntime : ModuleRules
 			new string[]
 			{
 				"Core",
+				"GameplayTags",
+				"InputCore",
+				"InputSettingsCore",
 				// ... add other public dependencies that you statically link with here ...
 			}
 			);
@@ -41,6 +44,7 @@ public class InputSettingsRuntime : ModuleRules
 				"GameFeatures",
 				"ModularGameplay",
 				"EnhancedInput",
+				"Json",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -2,16 +2,25 @@
 
 #include "EnhancedInputSubsystems.h"
 #include "InputMappingContext.h"
+#include "Engine/GameInstance.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/StreamableManager.h"
+#include "TimerManager.h"
+#include "Misc/ScopeExit.h"
+#include "UObject/ObjectSaveContext.h"
+#if WITH_EDITOR
+#include "Misc/DataValidation.h"
+#endif
+#include "InputSettingsStats.h"
+#include "Libs/InputBindingPlanCache.h"
 #include "Libs/UInputSettingFuncLib.h"
+#include "Subsystems/InputExtensionDispatcher.h"
 
 void UGameFeatureAction_AddInputs::OnGameFeatureActivating(FGameFeatureActivatingContext& Context)
 {
 	Super::OnGameFeatureActivating();
 
-	if (!ensureAlways(ActiveRequests.IsEmpty()))
-	{
-		ResetExtensions();
-	}
+	ActivateInputs();
 
 	const FGameFeatureStateChangeContext StateChangeContext(Context);
 
@@ -36,26 +45,339 @@ void UGameFeatureAction_AddInputs::OnGameFeatureDeactivating(FGameFeatureDeactiv
 
 	FWorldDelegates::OnStartGameInstance.Remove(GameInstanceStartHandle);
 
-	ResetExtensions();
+	for (const TPair<TWeakObjectPtr<UGameInstance>, FDelegateHandle>& Pair : LocalPlayerAddedHandles)
+	{
+		if (UGameInstance* const GameInstance = Pair.Key.Get())
+		{
+			GameInstance->OnLocalPlayerAddedEvent.Remove(Pair.Value);
+		}
+	}
+	LocalPlayerAddedHandles.Reset();
+	FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitializedActorsHandle);
+	WorldInitializedActorsHandle.Reset();
+
+	DeactivateInputs();
+}
+
+void UGameFeatureAction_AddInputs::ActivateInputs()
+{
+	if (!ensureAlways(ActiveDispatchers.IsEmpty()))
+	{
+		ResetExtensions();
+	}
+
+	PreloadInputSettings();
+
+	UpdateBindingsHash();
+	AppliedActionSettings = InputActionSettings;
+	bSettingsDiffPending = false;
+	CompileTagQuery();
 }
 
-UGameFrameworkComponentManager* UGameFeatureAction_AddInputs::GetGameFrameworkComponentManager(const FWorldContext& WorldContext) const
+void UGameFeatureAction_AddInputs::DeactivateInputs()
+{
+	{
+		BeginMappingBatch();
+		ON_SCOPE_EXIT { EndMappingBatch(); };
+
+		// the shared handlers stay registered for the other actions, this action's extensions are released below
+		for (const TWeakObjectPtr<UInputExtensionDispatcher>& Dispatcher : ActiveDispatchers)
+		{
+			if (Dispatcher.IsValid())
+			{
+				Dispatcher->RemoveListener(this);
+			}
+		}
+		ActiveDispatchers.Empty();
+
+		ResetExtensions();
+	}
+
+	if (InputSettingsLoadHandle.IsValid())
+	{
+		InputSettingsLoadHandle->CancelHandle();
+		InputSettingsLoadHandle.Reset();
+	}
+	PendingLoadActors.Reset();
+	PendingPlanActors.Reset();
+	bSettingsDiffPending = false;
+	for (const TPair<TWeakObjectPtr<UWorld>, FPendingExtensionQueue>& Pair : PendingExtensionQueues)
+	{
+		DEC_DWORD_STAT_BY(STAT_InputSettings_PendingExtensions, Pair.Value.ActorEventIndices.Num());
+	}
+	PendingExtensionQueues.Reset();
+	CachedTagMatches.Reset();
+
+	FInputBindingPlanCache::Get().Invalidate(InputActionSettings);
+	FInputBindingPlanCache::Get().Invalidate(AppliedActionSettings);
+}
+
+bool UGameFeatureAction_AddInputs::ApplyInputActionSettings(const FInputActionSettings& NewSettings)
+{
+	const bool bPawnClassChanged = !ActiveDispatchers.IsEmpty() && NewSettings.TargetPawnClass != AppliedActionSettings.TargetPawnClass;
+	if (bPawnClassChanged)
+	{
+		UE_LOG(LogInputSettings, Warning, TEXT("%s: TargetPawnClass of %s changed while active, it applies on the next activation."),
+		       *FString(__FUNCTION__), *GetPathName());
+	}
+
+	InputActionSettings = NewSettings;
+	// the cooked table describes the previous bindings
+	InputActionSettings.CompiledBindings.Reset();
+	ReapplyInputActionSettings();
+
+	return !bPawnClassChanged;
+}
+
+void UGameFeatureAction_AddInputs::ReapplyInputActionSettings()
+{
+	UpdateBindingsHash();
+
+	if (!(InputActionSettings.TagRequirements == AppliedActionSettings.TagRequirements))
+	{
+		CompileTagQuery();
+	}
+
+	if (ActiveDispatchers.IsEmpty())
+	{
+		ApplySettingsDiff();
+		return;
+	}
+
+	// stream the new bundle first, the extended actors are patched once it is resident instead of loading it synchronously
+	bSettingsDiffPending = true;
+	PreloadInputSettings();
+	if (bSettingsDiffPending && !IsPreloadingInputSettings())
+	{
+		ApplySettingsDiff();
+	}
+}
+
+void UGameFeatureAction_AddInputs::ApplySettingsDiff()
+{
+	FInputBindingPlanCache& PlanCache = FInputBindingPlanCache::Get();
+	bSettingsDiffPending = false;
+
+	{
+		BeginMappingBatch();
+		ON_SCOPE_EXIT { EndMappingBatch(); };
+
+		TArray<TPair<TWeakObjectPtr<AActor>, TObjectKey<AActor>>> ExtendedActors;
+		ExtendedActors.Reserve(ActiveExtensions.Num());
+		for (const FInputExtensionSlotMap::FEntry& Entry : ActiveExtensions.GetEntries())
+		{
+			ExtendedActors.Emplace(Entry.Actor, Entry.ActorKey);
+		}
+
+		for (const TPair<TWeakObjectPtr<AActor>, TObjectKey<AActor>>& ExtendedActor : ExtendedActors)
+		{
+			AActor* const TargetActor = ExtendedActor.Key.Get();
+			if (!IsValid(TargetActor))
+			{
+				RemoveActorInputs(ExtendedActor.Value);
+				continue;
+			}
+
+			// new requirements may exclude actors that were extended before
+			if (!DoesActorMatchTagRequirements(TargetActor))
+			{
+				RemoveActorInputs(TargetActor);
+				continue;
+			}
+
+			const FInputExtensionId Id = ActiveExtensions.Find(TargetActor);
+			const FInputExtensionSlotMap::FEntry* const Entry = ActiveExtensions.Get(Id);
+			if (Entry == nullptr) { continue; }
+
+			TArray<FInputBindingHandle> UpdatedHandles;
+			if (UInputSettingFuncLib::UpdateActorInputs(TargetActor, ActiveExtensions.GetHandles(*Entry), AppliedActionSettings,
+			                                            InputActionSettings, UpdatedHandles, GetActiveMappingBatch()))
+			{
+				ActiveExtensions.SetHandles(Id, UpdatedHandles);
+				ActiveExtensions.SetMapping(Id, InputActionSettings.InputMappingContext.Get(), InputActionSettings.MappingPriority);
+			}
+			else { RemoveActorInputs(TargetActor); }
+		}
+
+		// the dispatcher skipped the actors the old requirements rejected, extend the ones the new requirements admit
+		TArray<AActor*> ListenedActors;
+		for (const TWeakObjectPtr<UInputExtensionDispatcher>& Dispatcher : ActiveDispatchers)
+		{
+			if (Dispatcher.IsValid())
+			{
+				Dispatcher->GetExtendedActors(this, ListenedActors);
+			}
+		}
+
+		for (AActor* const TargetActor : ListenedActors)
+		{
+			if (ActiveExtensions.Contains(TargetActor) || PendingLoadActors.Contains(TargetActor) || PendingPlanActors.Contains(TargetActor))
+			{
+				continue;
+			}
+
+			if (DoesActorMatchTagRequirements(TargetActor) && !InputActionSettings.InputMappingContext.IsNull())
+			{
+				AddActorInputs(TargetActor);
+			}
+		}
+	}
+
+	// the previous content is no longer bound by this action, unless only non binding settings changed
+	if (AppliedActionSettings.BindingsHash != InputActionSettings.BindingsHash)
+	{
+		PlanCache.Invalidate(AppliedActionSettings);
+	}
+	AppliedActionSettings = InputActionSettings;
+}
+
+#if WITH_EDITOR
+void UGameFeatureAction_AddInputs::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	InputActionSettings.CompiledBindings.Reset();
+
+	// live tuning, patch the extended actors instead of waiting for a reactivation
+	ReapplyInputActionSettings();
+}
+
+void UGameFeatureAction_AddInputs::PreSave(FObjectPreSaveContext ObjectSaveContext)
+{
+	Super::PreSave(ObjectSaveContext);
+
+	// the flat table only ships in cooked data, editor saves keep the authored settings alone
+	InputActionSettings.CompiledBindings.Reset();
+	ON_SCOPE_EXIT { UpdateBindingsHash(); };
+	if (!ObjectSaveContext.IsCooking()) { return; }
+
+	// functions are only verified when the pawn binds them itself and its class is already loaded
+	const UClass* const OwnerClass = InputActionSettings.InputBindingOwner != EInputBindingOwnerOverride::Controller
+		                                 ? InputActionSettings.TargetPawnClass.Get()
+		                                 : nullptr;
+
+	TArray<FText> Errors;
+	if (!InputActionSettings.CompiledBindings.Build(InputActionSettings, OwnerClass, Errors))
+	{
+		for (const FText& Error : Errors)
+		{
+			UE_LOG(LogInputSettings, Error, TEXT("%s: %s: %s"), *FString(__FUNCTION__), *GetPathName(), *Error.ToString());
+		}
+	}
+}
+
+EDataValidationResult UGameFeatureAction_AddInputs::IsDataValid(FDataValidationContext& Context) const
+{
+	EDataValidationResult Result = Super::IsDataValid(Context);
+
+	const UClass* const OwnerClass = InputActionSettings.InputBindingOwner != EInputBindingOwnerOverride::Controller
+		                                 ? InputActionSettings.TargetPawnClass.LoadSynchronous()
+		                                 : nullptr;
+
+	// same checks the cook runs, surfaced in the editor before anything is cooked
+	FCompiledInputBindingTable ValidationTable;
+	TArray<FText> Errors;
+	if (!ValidationTable.Build(InputActionSettings, OwnerClass, Errors))
+	{
+		for (const FText& Error : Errors)
+		{
+			Context.AddError(Error);
+		}
+		Result = EDataValidationResult::Invalid;
+	}
+
+	if (FInputTagQuery TagQuery; !TagQuery.Compile(InputActionSettings.TagRequirements))
+	{
+		Context.AddError(FText::Format(NSLOCTEXT("InputSettings", "TooManyRequireTags", "Tag requirements use more than {0} distinct tags, they would match no actor."),
+		                               FInputTagQuery::MaxTags));
+		Result = EDataValidationResult::Invalid;
+	}
+
+	for (const FName& TagName : InputActionSettings.TagRequirements.RequireAllActorTagNames)
+	{
+		Context.AddWarning(FText::Format(NSLOCTEXT("InputSettings", "UnregisteredRequireTag", "Required tag {0} is not a registered gameplay tag, it only matches actor tags."),
+		                                 FText::FromName(TagName)));
+	}
+
+	return Result;
+}
+#endif
+
+void UGameFeatureAction_AddInputs::PostLoad()
+{
+	Super::PostLoad();
+
+	// migrate the legacy FName requirements, they were meant as "all of" and compared as is, a child tag didn't satisfy them
+	for (const FName& TagName : InputActionSettings.RequireTags_DEPRECATED)
+	{
+		if (const FGameplayTag Tag = FGameplayTag::RequestGameplayTag(TagName, false); Tag.IsValid())
+		{
+			InputActionSettings.TagRequirements.RequireAllExactTags.AddTag(Tag);
+		}
+		else
+		{
+			// dropping it would widen the requirement, keep matching it against the actor tags like before
+			InputActionSettings.TagRequirements.RequireAllActorTagNames.AddUnique(TagName);
+			UE_LOG(LogInputSettings, Warning, TEXT("%s: Required tag %s of %s is not a registered gameplay tag, kept as an actor tag name."),
+			       *FString(__FUNCTION__), *TagName.ToString(), *GetPathName());
+		}
+	}
+	InputActionSettings.RequireTags_DEPRECATED.Reset();
+
+	UpdateBindingsHash();
+}
+
+void UGameFeatureAction_AddInputs::CompileTagQuery()
+{
+	CachedTagMatches.Reset();
+	if (!CompiledTagQuery.Compile(InputActionSettings.TagRequirements))
+	{
+		UE_LOG(LogInputSettings, Error, TEXT("%s: %s has more than %d distinct required tags, no actor will be extended."),
+		       *FString(__FUNCTION__), *GetPathName(), FInputTagQuery::MaxTags);
+	}
+}
+
+void UGameFeatureAction_AddInputs::UpdateBindingsHash()
+{
+	InputActionSettings.BindingsHash = FInputBindingPlanCache::ComputeBindingsHash(InputActionSettings);
+}
+
+void UGameFeatureAction_AddInputs::InvalidateActorTagCache(const AActor* TargetActor)
+{
+	CachedTagMatches.Remove(TargetActor);
+
+	for (const TWeakObjectPtr<UInputExtensionDispatcher>& Dispatcher : ActiveDispatchers)
+	{
+		if (Dispatcher.IsValid())
+		{
+			Dispatcher->InvalidateActorTags(TargetActor);
+		}
+	}
+}
+
+UInputExtensionDispatcher* UGameFeatureAction_AddInputs::GetExtensionDispatcher(const FWorldContext& WorldContext) const
 {
 	if (!IsValid(WorldContext.World()) || !WorldContext.World()->IsGameWorld())
 	{
 		return nullptr;
 	}
 
-	return UGameInstance::GetSubsystem<UGameFrameworkComponentManager>(WorldContext.OwningGameInstance);
+	return UGameInstance::GetSubsystem<UInputExtensionDispatcher>(WorldContext.OwningGameInstance);
 }
 
 void UGameFeatureAction_AddInputs::ResetExtensions()
 {
-	// remove from all target actors using this gf
-	for (auto& [TargetActor,InputBindingData] : ActiveExtensions)
+	BeginMappingBatch();
+	ON_SCOPE_EXIT { EndMappingBatch(); };
+
+	// remove from all target actors using this gf, a linear walk over the packed entries
+	// entries of destroyed actors are released too, so LiveBindings and the mapping context references stay balanced
+	for (const FInputExtensionSlotMap::FEntry& Entry : ActiveExtensions.GetEntries())
 	{
-		RemoveActorInputs(TargetActor.Get());
+		ReleaseExtension(Entry, ActiveExtensions.GetHandles(Entry));
 	}
+
+	ActiveExtensions.Reset();
 }
 
 void UGameFeatureAction_AddInputs::HandleGameInstanceStart(UGameInstance* GameInstance, FGameFeatureStateChangeContext ChangeContext)
@@ -70,93 +392,373 @@ void UGameFeatureAction_AddInputs::HandleGameInstanceStart(UGameInstance* GameIn
 
 void UGameFeatureAction_AddInputs::AddToWorld(const FWorldContext& WorldContext)
 {
-	if (UGameFrameworkComponentManager* ComponentManager = GetGameFrameworkComponentManager(WorldContext);
-		IsValid(ComponentManager) && !InputActionSettings.TargetPawnClass.IsNull())
+	const UWorld* const World = WorldContext.World();
+	UGameInstance* const GameInstance = WorldContext.OwningGameInstance;
+	if (!IsValid(GameInstance) || (IsValid(World) && !World->IsGameWorld())) { return; }
+
+	// no local player can ever exist on a dedicated server, don't run the extension handler on every spawn
+	if (GameInstance->IsDedicatedServerInstance() || (IsValid(World) && World->GetNetMode() == NM_DedicatedServer)) { return; }
+
+	if (!IsValid(World) || GameInstance->GetNumLocalPlayers() == 0)
+	{
+		WaitForLocalPlayerWorld(GameInstance);
+		return;
+	}
+
+	if (UInputExtensionDispatcher* Dispatcher = GetExtensionDispatcher(WorldContext);
+		IsValid(Dispatcher) && !InputActionSettings.TargetPawnClass.IsNull())
+	{
+		// existing actors are extended synchronously while listening, by the new handler or by the dispatcher's replay
+		BeginMappingBatch();
+		ON_SCOPE_EXIT { EndMappingBatch(); };
+
+		if (Dispatcher->AddListener(this, InputActionSettings.TargetPawnClass))
+		{
+			ActiveDispatchers.AddUnique(Dispatcher);
+		}
+	}
+}
+
+void UGameFeatureAction_AddInputs::WaitForLocalPlayerWorld(UGameInstance* GameInstance)
+{
+	if (!LocalPlayerAddedHandles.Contains(GameInstance))
 	{
-		using FHandlerDelegate = UGameFrameworkComponentManager::FExtensionHandlerDelegate;
-		const FHandlerDelegate ExtensionHandlerDelegate = FHandlerDelegate::CreateUObject(this, &ThisClass::HandleActorExtension);
+		LocalPlayerAddedHandles.Add(GameInstance, GameInstance->OnLocalPlayerAddedEvent.AddUObject(this, &ThisClass::HandleLocalPlayerAdded));
+	}
 
-		ActiveRequests.Add(ComponentManager->AddExtensionHandler(InputActionSettings.TargetPawnClass, ExtensionHandlerDelegate));
+	if (!WorldInitializedActorsHandle.IsValid())
+	{
+		WorldInitializedActorsHandle = FWorldDelegates::OnWorldInitializedActors.AddUObject(this, &ThisClass::HandleWorldInitializedActors);
 	}
 }
 
-void UGameFeatureAction_AddInputs::HandleActorExtension(AActor* Owner, const FName EventName)
+void UGameFeatureAction_AddInputs::StopWaitingForLocalPlayerWorld(UGameInstance* GameInstance)
+{
+	FDelegateHandle LocalPlayerAddedHandle;
+	if (LocalPlayerAddedHandles.RemoveAndCopyValue(GameInstance, LocalPlayerAddedHandle))
+	{
+		GameInstance->OnLocalPlayerAddedEvent.Remove(LocalPlayerAddedHandle);
+	}
+
+	if (LocalPlayerAddedHandles.IsEmpty())
+	{
+		FWorldDelegates::OnWorldInitializedActors.Remove(WorldInitializedActorsHandle);
+		WorldInitializedActorsHandle.Reset();
+	}
+}
+
+void UGameFeatureAction_AddInputs::TryAddWaitingGameInstance(UGameInstance* GameInstance)
+{
+	if (!IsValid(GameInstance) || !LocalPlayerAddedHandles.Contains(GameInstance)) { return; }
+
+	// the first local player may be added before the world exists, keep waiting until both do
+	const FWorldContext* const WorldContext = GameInstance->GetWorldContext();
+	if (WorldContext == nullptr || !IsValid(WorldContext->World()) || GameInstance->GetNumLocalPlayers() == 0) { return; }
+
+	StopWaitingForLocalPlayerWorld(GameInstance);
+	AddToWorld(*WorldContext);
+}
+
+void UGameFeatureAction_AddInputs::HandleLocalPlayerAdded(ULocalPlayer* LocalPlayer)
+{
+	TryAddWaitingGameInstance(IsValid(LocalPlayer) ? LocalPlayer->GetGameInstance() : nullptr);
+}
+
+void UGameFeatureAction_AddInputs::HandleWorldInitializedActors(const UWorld::FActorsInitializedParams& Params)
+{
+	TryAddWaitingGameInstance(IsValid(Params.World) ? Params.World->GetGameInstance() : nullptr);
+}
+
+void UGameFeatureAction_AddInputs::HandleExtensionEvent(const FInputExtensionEvent& Event)
 {
-	if (EventName == UGameFrameworkComponentManager::NAME_ExtensionRemoved || EventName == UGameFrameworkComponentManager::NAME_ReceiverRemoved)
+	if (bBatchExtensionEvents && IsValid(Event.Actor) && IsValid(Event.Actor->GetWorld()))
 	{
+		EnqueueActorExtension(Event.Actor, Event.bAddInputs);
+	}
+	else if (Event.bAddInputs && Event.Subsystem == nullptr && !IsPreloadingInputSettings())
+	{
+		// nothing to bind without a local player, AddActorInputs would read the same cached lookup and give up
+		return;
+	}
+	else { ApplyActorExtension(Event.Actor, Event.bAddInputs, Event.TagsHash); }
+}
+
+void UGameFeatureAction_AddInputs::ApplyActorExtension(AActor* Owner, const bool bAddInputs, const TOptional<uint32>& KnownTagsHash)
+{
+	if (!bAddInputs)
+	{
+		// the dispatcher drops the pawn's resolved input once every listener released it
+		PendingLoadActors.Remove(Owner);
+		PendingPlanActors.Remove(Owner);
+		CachedTagMatches.Remove(Owner);
 		RemoveActorInputs(Owner);
 		return;
 	}
 
-	if (EventName == UGameFrameworkComponentManager::NAME_ExtensionAdded || EventName == UGameFrameworkComponentManager::NAME_GameActorReady
-		|| EventName == UGameFrameworkComponentManager::NAME_ReceiverAdded)
+	// avoid add multi times & only add to the actor has all require tags 
+	if (ActiveExtensions.Contains(Owner) || !DoesActorMatchTagRequirements(Owner, KnownTagsHash))
+	{
+		UE_LOG(LogInputSettings, Error, TEXT("%s: Input Mapping Context had add."), *FString(__FUNCTION__));
+		return;
+	}
+
+	// check input mapping context
+	if (InputActionSettings.InputMappingContext.IsNull())
+	{
+		UE_LOG(LogInputSettings, Error, TEXT("%s: Input Mapping Context is null."), *FString(__FUNCTION__));
+	}
+	else if (IsPreloadingInputSettings())
+	{
+		// bound in HandleInputSettingsLoaded instead of blocking on the loader
+		PendingLoadActors.AddUnique(Owner);
+	}
+	else { AddActorInputs(Owner); }
+}
+
+void UGameFeatureAction_AddInputs::EnqueueActorExtension(AActor* Owner, const bool bAddInputs)
+{
+	UWorld* const World = Owner->GetWorld();
+	FPendingExtensionQueue& Queue = PendingExtensionQueues.FindOrAdd(World);
+
+	if (const int32* const QueuedIndex = Queue.ActorEventIndices.Find(Owner))
 	{
-		// avoid add multi times & only add to the actor has all require tags 
-		if (ActiveExtensions.Contains(Owner) || !IsActorHasAllRequiredTags(Owner, InputActionSettings.RequireTags))
+		FPendingExtensionEvent& QueuedEvent = Queue.Events[*QueuedIndex];
+		if (QueuedEvent.bAddInputs.GetValue() == bAddInputs)
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s: Input Mapping Context had add."), *FString(__FUNCTION__));
+			// same operation already queued for this actor
+			++NumCoalescedExtensionEvents;
 			return;
 		}
 
-		// check input mapping context
-		if (InputActionSettings.InputMappingContext.IsNull())
+		// an add followed by a remove (or the opposite) leaves the actor as it is, drop both
+		QueuedEvent.bAddInputs.Reset();
+		Queue.ActorEventIndices.Remove(Owner);
+		NumCoalescedExtensionEvents += 2;
+		DEC_DWORD_STAT(STAT_InputSettings_PendingExtensions);
+		return;
+	}
+
+	Queue.ActorEventIndices.Add(Owner, Queue.Events.Add({Owner, Owner, bAddInputs}));
+	INC_DWORD_STAT(STAT_InputSettings_PendingExtensions);
+	ScheduleExtensionFlush(World, Queue);
+}
+
+void UGameFeatureAction_AddInputs::ScheduleExtensionFlush(UWorld* World, FPendingExtensionQueue& Queue)
+{
+	if (Queue.bFlushScheduled) { return; }
+
+	Queue.bFlushScheduled = true;
+	World->GetTimerManager().SetTimerForNextTick(
+		FTimerDelegate::CreateUObject(this, &ThisClass::FlushPendingExtensions, TWeakObjectPtr<UWorld>(World)));
+}
+
+void UGameFeatureAction_AddInputs::FlushPendingExtensions(TWeakObjectPtr<UWorld> WeakWorld)
+{
+	FPendingExtensionQueue* const Queue = PendingExtensionQueues.Find(WeakWorld);
+	if (Queue == nullptr) { return; }
+
+	Queue->bFlushScheduled = false;
+	if (!WeakWorld.IsValid())
+	{
+		DEC_DWORD_STAT_BY(STAT_InputSettings_PendingExtensions, Queue->ActorEventIndices.Num());
+		PendingExtensionQueues.Remove(WeakWorld);
+		return;
+	}
+
+	BeginMappingBatch();
+	ON_SCOPE_EXIT { EndMappingBatch(); };
+
+	const double BudgetSeconds = BatchTimeBudgetMs * 0.001;
+	const double StartTime = FPlatformTime::Seconds();
+
+	// applying an event never queues another one, the queue stays stable while flushing
+	while (Queue->NextEventIndex < Queue->Events.Num())
+	{
+		const FPendingExtensionEvent& Event = Queue->Events[Queue->NextEventIndex++];
+		if (!Event.bAddInputs.IsSet()) { continue; }
+
+		Queue->ActorEventIndices.Remove(Event.ActorKey);
+		DEC_DWORD_STAT(STAT_InputSettings_PendingExtensions);
+		if (AActor* const Actor = Event.Actor.Get())
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s: Input Mapping Context is null."), *FString(__FUNCTION__));
+			ApplyActorExtension(Actor, Event.bAddInputs.GetValue());
+		}
+		else if (!Event.bAddInputs.GetValue())
+		{
+			// destroyed while queued, the weak pointer can't find its entry anymore
+			CachedTagMatches.Remove(Event.ActorKey);
+			RemoveActorInputs(Event.ActorKey);
+		}
+
+		if (BudgetSeconds > 0. && FPlatformTime::Seconds() - StartTime > BudgetSeconds && Queue->NextEventIndex < Queue->Events.Num())
+		{
+			// out of budget, carry the rest over to the next frame
+			ScheduleExtensionFlush(WeakWorld.Get(), *Queue);
+			return;
 		}
-		else { AddActorInputs(Owner); }
 	}
+
+	PendingExtensionQueues.Remove(WeakWorld);
 }
 
-bool UGameFeatureAction_AddInputs::IsActorHasAllRequiredTags(const AActor* TargetActor, const TArray<FName>& InRequireTags) const
+bool UGameFeatureAction_AddInputs::DoesActorMatchTagRequirements(const AActor* TargetActor, const TOptional<uint32>& KnownTagsHash)
 {
 	if (!IsValid(TargetActor)) { return false; }
+	if (CompiledTagQuery.IsEmpty()) { return true; }
 
-	for (const FName& Tag : InRequireTags)
+	uint32 TagsHash = 0;
+	if (KnownTagsHash.IsSet()) { TagsHash = KnownTagsHash.GetValue(); }
+	else if (UInputExtensionDispatcher* const Dispatcher = UGameInstance::GetSubsystem<UInputExtensionDispatcher>(TargetActor->GetGameInstance()))
 	{
-		if (TargetActor->ActorHasTag(Tag))
-		{
-			return false;
-		}
+		TagsHash = Dispatcher->GetActorTagsHash(TargetActor);
+	}
+	else { TagsHash = FInputTagQuery::GetActorTagsHash(TargetActor); }
+	FCachedTagMatch& CachedMatch = CachedTagMatches.FindOrAdd(TargetActor, {~TagsHash, false});
+	if (CachedMatch.TagsHash != TagsHash)
+	{
+		CachedMatch.TagsHash = TagsHash;
+		CachedMatch.bMatches = CompiledTagQuery.MatchesActor(TargetActor);
 	}
 
-	return true;
+	return CachedMatch.bMatches;
 }
 
 void UGameFeatureAction_AddInputs::AddActorInputs(AActor* TargetActor)
 {
-	TArray<FInputBindingHandle> InputBindingHandles = UInputSettingFuncLib::AddActorInputs(TargetActor, InputActionSettings);
+	if (TryDeferToAsyncPlan(TargetActor)) { return; }
+
+	TArray<FInputBindingHandle> InputBindingHandles = UInputSettingFuncLib::AddActorInputs(TargetActor, InputActionSettings,
+	                                                                                       GetActiveMappingBatch());
 	if (InputBindingHandles.Num()>0)
 	{
-		// get or create input data associated to the target actor
-		FInputBindingData& NewInputData = ActiveExtensions.FindOrAdd(TargetActor);
-		// Add the mapping context to the input data
-		NewInputData.Mapping = InputActionSettings.InputMappingContext.LoadSynchronous();
+		// get or create the entry associated to the target actor, handles go to the shared pool
+		// the lookups are cached per pawn, kept with the entry to release it after the pawn is destroyed
+		ActiveExtensions.Add(TargetActor, UInputSettingFuncLib::GetEnhancedInputSubSystemFromActor(TargetActor),
+		                     UInputSettingFuncLib::GetInputComponentFromActor(TargetActor), InputActionSettings.InputMappingContext.Get(),
+		                     InputActionSettings.MappingPriority, InputBindingHandles);
+	}
+}
 
-		NewInputData.ActionBindingHandle.Append(InputBindingHandles);
+void UGameFeatureAction_AddInputs::PreloadInputSettings()
+{
+	if (InputSettingsLoadHandle.IsValid())
+	{
+		InputSettingsLoadHandle->CancelHandle();
 	}
+
+	// the handle is kept alive while the feature is active so the bundle stays resident
+	InputSettingsLoadHandle = UInputSettingFuncLib::RequestAsyncLoadInputSettings(
+		InputActionSettings, FStreamableDelegate::CreateUObject(this, &ThisClass::HandleInputSettingsLoaded));
 }
 
-void UGameFeatureAction_AddInputs::RemoveActorInputs(AActor* TargetActor)
+void UGameFeatureAction_AddInputs::HandleInputSettingsLoaded()
 {
-	if (!IsValid(TargetActor))
+	BeginMappingBatch();
+	ON_SCOPE_EXIT { EndMappingBatch(); };
+
+	// the extended actors move to the new settings before the waiting ones are bound with them
+	if (bSettingsDiffPending)
 	{
-		ActiveExtensions.Remove(TargetActor);
-		return;
+		ApplySettingsDiff();
 	}
+	BindPendingActors(PendingLoadActors);
+}
+
+bool UGameFeatureAction_AddInputs::TryDeferToAsyncPlan(AActor* TargetActor)
+{
+	if (!bPrepareBindingPlansAsync) { return false; }
+	if (PendingPlanActors.Contains(TargetActor)) { return true; }
+
+	const UObject* const FunctionOwner = UInputSettingFuncLib::GetInputOwnerObject(TargetActor, InputActionSettings.InputBindingOwner);
+	if (!IsValid(FunctionOwner)) { return false; }
+
+	// the plan is per owner class, only the first actor of a class pays for the compile and the rest just wait with it
+	UClass* const OwnerClass = FunctionOwner->GetClass();
+	FInputBindingPlanCache& PlanCache = FInputBindingPlanCache::Get();
+	if (PlanCache.Find(OwnerClass, InputActionSettings).IsValid()) { return false; }
+	if (!PlanCache.CompileAsync(OwnerClass, InputActionSettings, FSimpleDelegate::CreateUObject(this, &ThisClass::HandleBindingPlanReady)))
+	{
+		return false;
+	}
+
+	PendingPlanActors.Add(TargetActor);
+	return true;
+}
 
-	APawn* const TargetPawn = Cast<APawn>(TargetActor);
-	if (!IsValid(TargetPawn))
+void UGameFeatureAction_AddInputs::HandleBindingPlanReady()
+{
+	if (bSettingsDiffPending)
 	{
-		ActiveExtensions.Remove(TargetActor);
+		// compiled from the previous settings, bind the waiting actors with the new ones once they are streamed
+		for (const TWeakObjectPtr<AActor>& PendingActor : PendingPlanActors)
+		{
+			PendingLoadActors.AddUnique(PendingActor);
+		}
+		PendingPlanActors.Reset();
 		return;
 	}
 
-	// Check if there's existing active input data
-	if (const FInputBindingData* const ActiveInputData = ActiveExtensions.Find(TargetActor))
+	// a plan invalidated while compiling is compiled in place rather than queued again
+	TGuardValue<bool> CompileInPlaceGuard(bPrepareBindingPlansAsync, false);
+	BindPendingActors(PendingPlanActors);
+}
+
+void UGameFeatureAction_AddInputs::BindPendingActors(TArray<TWeakObjectPtr<AActor>>& PendingActors)
+{
+	TArray<TWeakObjectPtr<AActor>> ReadyActors = MoveTemp(PendingActors);
+	PendingActors.Reset();
+
+	BeginMappingBatch();
+	ON_SCOPE_EXIT { EndMappingBatch(); };
+
+	for (const TWeakObjectPtr<AActor>& PendingActor : ReadyActors)
+	{
+		if (AActor* const TargetActor = PendingActor.Get(); IsValid(TargetActor) && !ActiveExtensions.Contains(TargetActor))
+		{
+			AddActorInputs(TargetActor);
+		}
+	}
+}
+
+bool UGameFeatureAction_AddInputs::IsPreloadingInputSettings() const
+{
+	return InputSettingsLoadHandle.IsValid() && InputSettingsLoadHandle->IsLoadingInProgress();
+}
+
+void UGameFeatureAction_AddInputs::RemoveActorInputs(const TObjectKey<AActor> TargetActor)
+{
+	// Release the bindings of the existing active input data, if any
+	ActiveExtensions.Remove(TargetActor,
+		[this](const FInputExtensionSlotMap::FEntry& Entry, TConstArrayView<FInputBindingHandle> TargetHandles)
+		{
+			ReleaseExtension(Entry, TargetHandles);
+		});
+}
+
+void UGameFeatureAction_AddInputs::ReleaseExtension(const FInputExtensionSlotMap::FEntry& Entry, TConstArrayView<FInputBindingHandle> Handles)
+{
+	// always through the lookups cached at bind time, the actor may be gone or already possessed by another player
+	UInputSettingFuncLib::RemoveResolvedInputs(Entry.Subsystem.Get(), Entry.InputComponent.Get(), Handles, Entry.Mapping.Get(),
+	                                           Entry.MappingPriority, GetActiveMappingBatch());
+}
+
+void UGameFeatureAction_AddInputs::BeginMappingBatch()
+{
+	if (MappingBatchDepth++ == 0)
+	{
+		UInputMappingContextRegistry::BeginMappingContextBatch(MappingBatch);
+	}
+}
+
+void UGameFeatureAction_AddInputs::EndMappingBatch()
+{
+	if (ensure(MappingBatchDepth > 0) && --MappingBatchDepth == 0)
 	{
-		const auto& [TargetHandles,TargetMapping] = ActiveExtensions[TargetActor];
-		UInputSettingFuncLib::RemoveActorInputs(TargetActor, TargetHandles, TargetMapping.Get());
+		UInputMappingContextRegistry::CommitMappingContextBatch(MappingBatch);
 	}
-	
-	ActiveExtensions.Remove(TargetActor);
+}
+
+FInputMappingContextBatch* UGameFeatureAction_AddInputs::GetActiveMappingBatch()
+{
+	return MappingBatchDepth > 0 ? &MappingBatch : nullptr;
 }
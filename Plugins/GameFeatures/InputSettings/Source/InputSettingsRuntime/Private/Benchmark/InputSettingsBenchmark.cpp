@@ -0,0 +1,358 @@
+﻿#include "Actions/GameFeatureAction_AddInputs.h"
+
+#include "EnhancedInputComponent.h"
+#include "Components/GameFrameworkComponentManager.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "HAL/MemoryBase.h"
+#include "Libs/UInputSettingFuncLib.h"
+#include "Misc/App.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Policies/PrettyJsonPrintPolicy.h"
+#include "Serialization/JsonWriter.h"
+#include "Subsystems/InputMappingContextRegistry.h"
+#include "UObject/UObjectIterator.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// the measured add/remove work is scoped under this tag, its byte count is read back from LLM
+LLM_DEFINE_TAG(InputSettingsBenchmark);
+
+/*
+ * Add/remove churn benchmark of UGameFeatureAction_AddInputs, run as an automation test in a game world:
+ *   <Project> -game -nullrhi -llm -ExecCmds="Automation RunTests InputSettings.Benchmark; Quit"
+ * Allocation counts come from the allocator stats and are process wide, the byte count of the measured scope needs -llm and is -1 without it.
+ * -InputSettingsBenchmarkPawns=1,100 overrides the pawn counts, -InputSettingsBenchmarkAction= filters the action by path.
+ * Results go to Saved/Profiling/InputSettings as CSV and JSON.
+ */
+class FInputSettingsBenchmark
+{
+public:
+	struct FPassResult
+	{
+		int32 NumPawns = 0;
+		double ActivateMs = 0.;
+		double DeactivateMs = 0.;
+		double AddTotalMs = 0.;
+		double AddMaxMs = 0.;
+		double RemoveTotalMs = 0.;
+		double RemoveMaxMs = 0.;
+		int32 MappingRebuilds = 0;
+		int64 AddAllocations = 0;
+		int64 RemoveAllocations = 0;
+		int64 RetainedBytes = INDEX_NONE;
+		int32 LeakedPoolHandles = 0;
+		int32 LeakedComponentBindings = 0;
+	};
+
+	static bool Run(FAutomationTestBase& Test);
+
+private:
+	static UWorld* FindGameWorld();
+	static UGameFeatureAction_AddInputs* FindSourceAction(const FString& PathFilter);
+	static FPassResult RunPass(UWorld* World, APlayerController* PlayerController, const UGameFeatureAction_AddInputs* SourceAction,
+	                           UClass* PawnClass, const int32 NumPawns);
+	static void WriteResults(const TArray<FPassResult>& Results, const FString& ActionPath);
+
+	static double CyclesToMs(const uint64 Cycles) { return FPlatformTime::ToMilliseconds64(Cycles); }
+
+	static int64 GetAllocationCalls();
+	// bytes currently tracked under the benchmark LLM tag, INDEX_NONE when LLM isn't running
+	static int64 GetTrackedBytes();
+};
+
+bool FInputSettingsBenchmark::Run(FAutomationTestBase& Test)
+{
+	UWorld* const World = FindGameWorld();
+	if (!IsValid(World))
+	{
+		Test.AddError(TEXT("Benchmark needs a game world, run it with -game or in PIE."));
+		return false;
+	}
+
+	APlayerController* const PlayerController = World->GetFirstPlayerController();
+	if (!IsValid(PlayerController) || !PlayerController->IsLocalController())
+	{
+		Test.AddError(TEXT("Benchmark needs a local player controller."));
+		return false;
+	}
+
+	TArray<int32> PawnCounts = {1, 100, 1000, 10000};
+	if (FString CountsValue; FParse::Value(FCommandLine::Get(), TEXT("-InputSettingsBenchmarkPawns="), CountsValue, false))
+	{
+		TArray<FString> CountStrings;
+		CountsValue.ParseIntoArray(CountStrings, TEXT(","));
+
+		PawnCounts.Reset();
+		for (const FString& CountString : CountStrings)
+		{
+			PawnCounts.Add(FMath::Max(1, FCString::Atoi(*CountString)));
+		}
+	}
+
+	FString PathFilter;
+	FParse::Value(FCommandLine::Get(), TEXT("-InputSettingsBenchmarkAction="), PathFilter);
+
+	const UGameFeatureAction_AddInputs* const SourceAction = FindSourceAction(PathFilter);
+	if (SourceAction == nullptr)
+	{
+		Test.AddError(TEXT("No UGameFeatureAction_AddInputs with a TargetPawnClass is loaded."));
+		return false;
+	}
+
+	UClass* const PawnClass = SourceAction->InputActionSettings.TargetPawnClass.LoadSynchronous();
+	if (!IsValid(PawnClass))
+	{
+		Test.AddError(FString::Printf(TEXT("Failed to load TargetPawnClass of %s."), *SourceAction->GetPathName()));
+		return false;
+	}
+
+	if (!SourceAction->ActiveDispatchers.IsEmpty())
+	{
+		// the extension events of the spawned pawns reach the live action as well
+		Test.AddWarning(FString::Printf(TEXT("%s is active, its handling is included in the measurements."), *SourceAction->GetPathName()));
+	}
+
+	TArray<FPassResult> Results;
+	for (const int32 NumPawns : PawnCounts)
+	{
+		const FPassResult& Result = Results.Add_GetRef(RunPass(World, PlayerController, SourceAction, PawnClass, NumPawns));
+		Test.TestEqual(FString::Printf(TEXT("Leaked pool handles with %d pawns"), NumPawns), Result.LeakedPoolHandles, 0);
+		Test.TestEqual(FString::Printf(TEXT("Leaked component bindings with %d pawns"), NumPawns), Result.LeakedComponentBindings, 0);
+	}
+
+	WriteResults(Results, SourceAction->GetPathName());
+	return true;
+}
+
+int64 FInputSettingsBenchmark::GetAllocationCalls()
+{
+#if !UE_BUILD_SHIPPING
+	return static_cast<int64>(FMalloc::TotalMallocCalls.load(std::memory_order_relaxed) + FMalloc::TotalReallocCalls.load(std::memory_order_relaxed));
+#else
+	return 0;
+#endif
+}
+
+int64 FInputSettingsBenchmark::GetTrackedBytes()
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	FLowLevelMemTracker& MemTracker = FLowLevelMemTracker::Get();
+	if (!MemTracker.IsEnabled()) { return INDEX_NONE; }
+
+	// the per thread counts are only folded into the tag totals when the stats are published
+	MemTracker.UpdateStatsPerFrame();
+	return MemTracker.GetTagAmountForTracker(ELLMTracker::Default, FName(TEXT("InputSettingsBenchmark")), ELLMTagSet::None);
+#else
+	return INDEX_NONE;
+#endif
+}
+
+UWorld* FInputSettingsBenchmark::FindGameWorld()
+{
+	for (const FWorldContext& WorldContext : GEngine->GetWorldContexts())
+	{
+		if ((WorldContext.WorldType == EWorldType::Game || WorldContext.WorldType == EWorldType::PIE) && IsValid(WorldContext.World()))
+		{
+			return WorldContext.World();
+		}
+	}
+
+	return nullptr;
+}
+
+UGameFeatureAction_AddInputs* FInputSettingsBenchmark::FindSourceAction(const FString& PathFilter)
+{
+	for (TObjectIterator<UGameFeatureAction_AddInputs> It(RF_ClassDefaultObject | RF_ArchetypeObject); It; ++It)
+	{
+		if (It->InputActionSettings.TargetPawnClass.IsNull()) { continue; }
+		if (!PathFilter.IsEmpty() && !It->GetPathName().Contains(PathFilter)) { continue; }
+
+		return *It;
+	}
+
+	return nullptr;
+}
+
+FInputSettingsBenchmark::FPassResult FInputSettingsBenchmark::RunPass(UWorld* World, APlayerController* PlayerController,
+                                                                      const UGameFeatureAction_AddInputs* SourceAction,
+                                                                      UClass* PawnClass, const int32 NumPawns)
+{
+	FPassResult Result;
+	Result.NumPawns = NumPawns;
+
+	const FWorldContext* const WorldContext = GEngine->GetWorldContextFromWorld(World);
+	UGameFrameworkComponentManager* const ComponentManager = UGameInstance::GetSubsystem<UGameFrameworkComponentManager>(World->GetGameInstance());
+	if (WorldContext == nullptr || !IsValid(ComponentManager)) { return Result; }
+
+	// a transient copy, so the live feature state is left untouched
+	UGameFeatureAction_AddInputs* const Action = DuplicateObject(SourceAction, GetTransientPackage());
+	// every add is measured where it happens
+	Action->bPrepareBindingPlansAsync = false;
+	Action->bBatchExtensionEvents = false;
+
+	APawn* const OriginalPawn = PlayerController->GetPawn();
+	const UEnhancedInputComponent* const InputComponent = Cast<UEnhancedInputComponent>(PlayerController->InputComponent.Get());
+	const int32 BaselineBindings = IsValid(InputComponent) ? InputComponent->GetActionEventBindings().Num() : 0;
+	const int32 BaselineRebuilds = UInputMappingContextRegistry::GetNumMappingRebuildRequests();
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	TArray<APawn*> Pawns;
+	Pawns.Reserve(NumPawns);
+	const int32 GridSize = FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumPawns)));
+	for (int32 Index = 0; Index < NumPawns; ++Index)
+	{
+		const FVector Location((Index % GridSize) * 200., (Index / GridSize) * 200., 100000.);
+		if (APawn* const Pawn = World->SpawnActor<APawn>(PawnClass, FTransform(Location), SpawnParameters))
+		{
+			ComponentManager->AddReceiver(Pawn);
+			Pawns.Add(Pawn);
+		}
+	}
+
+	// activation, the bundle is streamed up front so only the binding work is measured
+	Action->ActivateInputs();
+	if (Action->InputSettingsLoadHandle.IsValid())
+	{
+		Action->InputSettingsLoadHandle->WaitUntilComplete();
+	}
+
+	uint64 StartCycles = FPlatformTime::Cycles64();
+	Action->AddToWorld(*WorldContext);
+	Result.ActivateMs = CyclesToMs(FPlatformTime::Cycles64() - StartCycles);
+
+	// possession churn, every pawn is possessed, extended and released in turn through the shared extension handler
+	const int64 StartTrackedBytes = GetTrackedBytes();
+	for (APawn* const Pawn : Pawns)
+	{
+		PlayerController->Possess(Pawn);
+
+		LLM_SCOPE_BYTAG(InputSettingsBenchmark);
+		int64 StartAllocations = GetAllocationCalls();
+		StartCycles = FPlatformTime::Cycles64();
+		ComponentManager->SendExtensionEvent(Pawn, UGameFrameworkComponentManager::NAME_GameActorReady);
+		const double AddMs = CyclesToMs(FPlatformTime::Cycles64() - StartCycles);
+		Result.AddAllocations += GetAllocationCalls() - StartAllocations;
+
+		StartAllocations = GetAllocationCalls();
+		StartCycles = FPlatformTime::Cycles64();
+		ComponentManager->SendExtensionEvent(Pawn, UGameFrameworkComponentManager::NAME_ExtensionRemoved);
+		const double RemoveMs = CyclesToMs(FPlatformTime::Cycles64() - StartCycles);
+		Result.RemoveAllocations += GetAllocationCalls() - StartAllocations;
+
+		Result.AddTotalMs += AddMs;
+		Result.AddMaxMs = FMath::Max(Result.AddMaxMs, AddMs);
+		Result.RemoveTotalMs += RemoveMs;
+		Result.RemoveMaxMs = FMath::Max(Result.RemoveMaxMs, RemoveMs);
+	}
+	// bytes the churn left allocated, every extension was released so this is expected to stay flat
+	if (const int64 EndTrackedBytes = GetTrackedBytes(); StartTrackedBytes != INDEX_NONE && EndTrackedBytes != INDEX_NONE)
+	{
+		Result.RetainedBytes = EndTrackedBytes - StartTrackedBytes;
+	}
+
+	// every extension of the churn was released, anything still pooled or bound leaked
+	Result.LeakedPoolHandles = Action->ActiveExtensions.NumHandles();
+	Result.LeakedComponentBindings = IsValid(InputComponent) ? InputComponent->GetActionEventBindings().Num() - BaselineBindings : 0;
+
+	// leave the last pawn extended so deactivation has something to tear down
+	if (Pawns.Num() > 0)
+	{
+		ComponentManager->SendExtensionEvent(Pawns.Last(), UGameFrameworkComponentManager::NAME_GameActorReady);
+	}
+
+	StartCycles = FPlatformTime::Cycles64();
+	Action->DeactivateInputs();
+	Result.DeactivateMs = CyclesToMs(FPlatformTime::Cycles64() - StartCycles);
+
+	Result.MappingRebuilds = UInputMappingContextRegistry::GetNumMappingRebuildRequests() - BaselineRebuilds;
+	// and deactivation must unbind the extension it was left with
+	Result.LeakedComponentBindings += IsValid(InputComponent) ? InputComponent->GetActionEventBindings().Num() - BaselineBindings : 0;
+
+	for (APawn* const Pawn : Pawns)
+	{
+		ComponentManager->RemoveReceiver(Pawn);
+		Pawn->Destroy();
+	}
+
+	if (IsValid(OriginalPawn))
+	{
+		PlayerController->Possess(OriginalPawn);
+	}
+
+	UE_LOG(LogInputSettings, Display, TEXT("%s: %d pawns, add avg %.4f ms, remove avg %.4f ms, %lld allocations, %d rebuilds, %d leaked handles."),
+	       *FString(__FUNCTION__), NumPawns, Result.AddTotalMs / FMath::Max(1, NumPawns), Result.RemoveTotalMs / FMath::Max(1, NumPawns),
+	       Result.AddAllocations + Result.RemoveAllocations, Result.MappingRebuilds, Result.LeakedPoolHandles + Result.LeakedComponentBindings);
+
+	return Result;
+}
+
+void FInputSettingsBenchmark::WriteResults(const TArray<FPassResult>& Results, const FString& ActionPath)
+{
+	const FString OutputDir = FPaths::ProfilingDir() / TEXT("InputSettings");
+	const FString BaseName = FString::Printf(TEXT("Benchmark-%s"), *FDateTime::Now().ToString());
+	IFileManager::Get().MakeDirectory(*OutputDir, true);
+
+	FString Csv = TEXT("NumPawns,ActivateMs,DeactivateMs,AddAvgMs,AddMaxMs,RemoveAvgMs,RemoveMaxMs,MappingRebuilds,AddAllocations,RemoveAllocations,RetainedBytes,LeakedPoolHandles,LeakedComponentBindings\n");
+	FString Json;
+	const TSharedRef<TJsonWriter<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>> JsonWriter = TJsonWriterFactory<TCHAR, TPrettyJsonPrintPolicy<TCHAR>>::Create(&Json);
+	JsonWriter->WriteObjectStart();
+	JsonWriter->WriteValue(TEXT("Action"), ActionPath);
+	JsonWriter->WriteValue(TEXT("BuildVersion"), FString(FApp::GetBuildVersion()));
+	JsonWriter->WriteArrayStart(TEXT("Passes"));
+
+	for (const FPassResult& Result : Results)
+	{
+		const double AddAvgMs = Result.AddTotalMs / FMath::Max(1, Result.NumPawns);
+		const double RemoveAvgMs = Result.RemoveTotalMs / FMath::Max(1, Result.NumPawns);
+
+		Csv += FString::Printf(TEXT("%d,%f,%f,%f,%f,%f,%f,%d,%lld,%lld,%lld,%d,%d\n"), Result.NumPawns, Result.ActivateMs, Result.DeactivateMs,
+		                       AddAvgMs, Result.AddMaxMs, RemoveAvgMs, Result.RemoveMaxMs, Result.MappingRebuilds, Result.AddAllocations,
+		                       Result.RemoveAllocations, Result.RetainedBytes, Result.LeakedPoolHandles, Result.LeakedComponentBindings);
+
+		JsonWriter->WriteObjectStart();
+		JsonWriter->WriteValue(TEXT("NumPawns"), Result.NumPawns);
+		JsonWriter->WriteValue(TEXT("ActivateMs"), Result.ActivateMs);
+		JsonWriter->WriteValue(TEXT("DeactivateMs"), Result.DeactivateMs);
+		JsonWriter->WriteValue(TEXT("AddAvgMs"), AddAvgMs);
+		JsonWriter->WriteValue(TEXT("AddMaxMs"), Result.AddMaxMs);
+		JsonWriter->WriteValue(TEXT("RemoveAvgMs"), RemoveAvgMs);
+		JsonWriter->WriteValue(TEXT("RemoveMaxMs"), Result.RemoveMaxMs);
+		JsonWriter->WriteValue(TEXT("MappingRebuilds"), Result.MappingRebuilds);
+		JsonWriter->WriteValue(TEXT("AddAllocations"), Result.AddAllocations);
+		JsonWriter->WriteValue(TEXT("RemoveAllocations"), Result.RemoveAllocations);
+		JsonWriter->WriteValue(TEXT("RetainedBytes"), Result.RetainedBytes);
+		JsonWriter->WriteValue(TEXT("LeakedPoolHandles"), Result.LeakedPoolHandles);
+		JsonWriter->WriteValue(TEXT("LeakedComponentBindings"), Result.LeakedComponentBindings);
+		JsonWriter->WriteObjectEnd();
+	}
+
+	JsonWriter->WriteArrayEnd();
+	JsonWriter->WriteObjectEnd();
+	JsonWriter->Close();
+
+	FFileHelper::SaveStringToFile(Csv, *(OutputDir / BaseName + TEXT(".csv")));
+	FFileHelper::SaveStringToFile(Json, *(OutputDir / BaseName + TEXT(".json")));
+
+	UE_LOG(LogInputSettings, Display, TEXT("%s: Results written to %s."), *FString(__FUNCTION__), *(OutputDir / BaseName));
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FInputSettingsBenchmarkTest, "InputSettings.Benchmark.AddRemoveChurn",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FInputSettingsBenchmarkTest::RunTest(const FString& Parameters)
+{
+	return FInputSettingsBenchmark::Run(*this);
+}
+
+#endif
@@ -2,6 +2,8 @@
 
 #include "InputSettingsRuntimeModule.h"
 
+#include "Libs/InputBindingPlanCache.h"
+
 #define LOCTEXT_NAMESPACE "FInputSettingsRuntimeModule"
 
 void FInputSettingsRuntimeModule::StartupModule()
@@ -14,6 +16,7 @@ void FInputSettingsRuntimeModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.
 	// For modules that support dynamic reloading, we call this function before unloading the module.
+	FInputBindingPlanCache::TearDown();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -0,0 +1,9 @@
+﻿#include "InputSettingsStats.h"
+
+DEFINE_STAT(STAT_InputSettings_AddActorInputs);
+DEFINE_STAT(STAT_InputSettings_SetupInputBindings);
+DEFINE_STAT(STAT_InputSettings_RemoveActorInputs);
+DEFINE_STAT(STAT_InputSettings_SyncLoad);
+
+DEFINE_STAT(STAT_InputSettings_LiveBindings);
+DEFINE_STAT(STAT_InputSettings_PendingExtensions);
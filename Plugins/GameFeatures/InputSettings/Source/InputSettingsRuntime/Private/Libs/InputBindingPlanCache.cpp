@@ -0,0 +1,320 @@
+﻿#include "Libs/InputBindingPlanCache.h"
+
+#include "Hash/xxhash.h"
+#include "InputAction.h"
+#include "InputSettingsStats.h"
+#include "Libs/InputNativeBindingRegistry.h"
+#include "Libs/UInputSettingFuncLib.h"
+#include "Tasks/Task.h"
+#include "Types/InputSettingStructs.h"
+#include "UObject/GarbageCollection.h"
+
+namespace InputBindingPlanCache
+{
+	FInputBindingPlanCache* Instance = nullptr;
+}
+
+FInputBindingPlanCache& FInputBindingPlanCache::Get()
+{
+	if (InputBindingPlanCache::Instance == nullptr)
+	{
+		InputBindingPlanCache::Instance = new FInputBindingPlanCache();
+	}
+
+	return *InputBindingPlanCache::Instance;
+}
+
+void FInputBindingPlanCache::TearDown()
+{
+	delete InputBindingPlanCache::Instance;
+	InputBindingPlanCache::Instance = nullptr;
+}
+
+FInputBindingPlanCache::FInputBindingPlanCache()
+{
+	ReloadCompleteHandle = FCoreUObjectDelegates::ReloadCompleteDelegate.AddRaw(this, &FInputBindingPlanCache::HandleReloadComplete);
+	BindersChangedHandle = FInputNativeBindingRegistry::Get().OnBindersChanged.AddRaw(this, &FInputBindingPlanCache::InvalidateAll);
+#if WITH_EDITOR
+	ObjectsReplacedHandle = FCoreUObjectDelegates::OnObjectsReplaced.AddRaw(this, &FInputBindingPlanCache::HandleObjectsReplaced);
+#endif
+}
+
+FInputBindingPlanCache::~FInputBindingPlanCache()
+{
+	FCoreUObjectDelegates::ReloadCompleteDelegate.Remove(ReloadCompleteHandle);
+	// the registry module outlives this one
+	FInputNativeBindingRegistry::Get().OnBindersChanged.Remove(BindersChangedHandle);
+#if WITH_EDITOR
+	FCoreUObjectDelegates::OnObjectsReplaced.Remove(ObjectsReplacedHandle);
+#endif
+}
+
+TSharedRef<const FInputBindingPlan> FInputBindingPlanCache::FindOrCompile(UClass* OwnerClass, const FInputActionSettings& ActionSettings)
+{
+	const FPlanKey Key{OwnerClass, GetBindingsHash(ActionSettings)};
+	if (const TSharedRef<FInputBindingPlan>* const CachedPlan = Plans.Find(Key))
+	{
+		return *CachedPlan;
+	}
+
+	const TSharedRef<FInputBindingPlan> Plan = MakeShared<FInputBindingPlan>();
+	Plan->OwnerClass = OwnerClass;
+	CompilePlan(*Plan, ActionSettings, true);
+
+	return Plans.Add(Key, Plan);
+}
+
+TSharedPtr<const FInputBindingPlan> FInputBindingPlanCache::Find(UClass* OwnerClass, const FInputActionSettings& ActionSettings) const
+{
+	const TSharedRef<FInputBindingPlan>* const CachedPlan = Plans.Find(FPlanKey{OwnerClass, GetBindingsHash(ActionSettings)});
+	return CachedPlan != nullptr ? TSharedPtr<const FInputBindingPlan>(*CachedPlan) : nullptr;
+}
+
+bool FInputBindingPlanCache::CompileAsync(UClass* OwnerClass, const FInputActionSettings& ActionSettings, FSimpleDelegate OnReady)
+{
+	check(IsInGameThread());
+	if (!IsValid(OwnerClass) || !UInputSettingFuncLib::IsInputSettingsLoaded(ActionSettings)) { return false; }
+
+	const FPlanKey Key{OwnerClass, GetBindingsHash(ActionSettings)};
+	if (FPendingPlan* const PendingPlan = PendingPlans.Find(Key))
+	{
+		PendingPlan->OnReady.Add(MoveTemp(OnReady));
+		return true;
+	}
+
+	FPendingPlan& PendingPlan = PendingPlans.Add(Key, {MakeShared<FInputBindingPlan>()});
+	PendingPlan.Plan->OwnerClass = OwnerClass;
+	PendingPlan.OnReady.Add(MoveTemp(OnReady));
+
+	// the worker gets its own copy, the settings may be edited on the game thread meanwhile
+	const UE::Tasks::FTask CompileTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[Plan = PendingPlan.Plan, Settings = ActionSettings]()
+		{
+			// no GC while objects are looked up and written into the plan, the pending plan is reported once it is complete
+			FGCScopeGuard GCGuard;
+			CompilePlan(*Plan, Settings, false);
+		});
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[Key, CompiledGeneration = Generation]() { CommitAsyncPlan(Key, CompiledGeneration); },
+		UE::Tasks::Prerequisites(CompileTask), LowLevelTasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+
+	return true;
+}
+
+void FInputBindingPlanCache::CommitAsyncPlan(const FPlanKey Key, const uint32 CompiledGeneration)
+{
+	if (InputBindingPlanCache::Instance == nullptr) { return; }
+	FInputBindingPlanCache& Cache = *InputBindingPlanCache::Instance;
+
+	FPendingPlan* const FoundPlan = Cache.PendingPlans.Find(Key);
+	if (FoundPlan == nullptr) { return; }
+
+	const FPendingPlan PendingPlan = MoveTemp(*FoundPlan);
+	Cache.PendingPlans.Remove(Key);
+
+	// settings edited or released, or classes reloaded while compiling, the waiting callers compile again in place
+	if (CompiledGeneration == Cache.Generation && !Cache.Plans.Contains(Key))
+	{
+		Cache.Plans.Add(Key, PendingPlan.Plan);
+	}
+
+	for (const FSimpleDelegate& OnReady : PendingPlan.OnReady)
+	{
+		OnReady.ExecuteIfBound();
+	}
+}
+
+void FInputBindingPlanCache::Invalidate(const FInputActionSettings& ActionSettings)
+{
+	++Generation;
+	const uint64 BindingsHash = GetBindingsHash(ActionSettings);
+	for (auto It = Plans.CreateIterator(); It; ++It)
+	{
+		if (It.Key().BindingsHash == BindingsHash)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+uint64 FInputBindingPlanCache::GetBindingsHash(const FInputActionSettings& ActionSettings)
+{
+	return ActionSettings.BindingsHash != 0 ? ActionSettings.BindingsHash : ComputeBindingsHash(ActionSettings);
+}
+
+uint64 FInputBindingPlanCache::ComputeBindingsHash(const FInputActionSettings& ActionSettings)
+{
+	FXxHash64Builder Builder;
+	const auto Update = [&Builder](const uint32 Value) { Builder.Update(&Value, sizeof(Value)); };
+
+	for (const auto& [ActionInput, FunctionBindingData] : ActionSettings.ActionsBindings)
+	{
+		Update(GetTypeHash(ActionInput.ToSoftObjectPath()));
+		Update(FunctionBindingData.Num());
+		for (const auto& [FunctionName, Triggers, bPreferNativeBinding] : FunctionBindingData)
+		{
+			Update(GetTypeHash(FunctionName));
+			Update(bPreferNativeBinding);
+			Update(Triggers.Num());
+			for (const ETriggerEvent Trigger : Triggers)
+			{
+				Update(static_cast<uint32>(Trigger));
+			}
+		}
+	}
+
+	// a compiled table replaces the authored bindings, it is part of the content
+	const FCompiledInputBindingTable& Table = ActionSettings.CompiledBindings;
+	Update(Table.IsCompiled());
+	if (Table.IsCompiled())
+	{
+		for (const FSoftObjectPath& ActionPath : Table.Actions)
+		{
+			Update(GetTypeHash(ActionPath));
+		}
+		for (const auto& [ActionIndex, FunctionName, TriggerMask, bPreferNativeBinding] : Table.Bindings)
+		{
+			Update(ActionIndex);
+			Update(GetTypeHash(FunctionName));
+			Update(TriggerMask);
+			Update(bPreferNativeBinding);
+		}
+	}
+
+	return Builder.Finalize().Hash;
+}
+
+void FInputBindingPlanCache::InvalidateAll()
+{
+	++Generation;
+	Plans.Reset();
+}
+
+void FInputBindingPlanCache::AddReferencedObjects(FReferenceCollector& Collector)
+{
+	// keeps the owner class (and so the resolved UFunctions) and the actions alive while planned
+	for (auto& [Key, Plan] : Plans)
+	{
+		Collector.AddReferencedObject(Plan->OwnerClass);
+		Collector.AddReferencedObjects(Plan->Actions);
+	}
+
+	// workers hold a GC guard while writing, a pending plan is either untouched or complete here
+	for (auto& [Key, PendingPlan] : PendingPlans)
+	{
+		Collector.AddReferencedObject(PendingPlan.Plan->OwnerClass);
+		Collector.AddReferencedObjects(PendingPlan.Plan->Actions);
+	}
+}
+
+FString FInputBindingPlanCache::GetReferencerName() const
+{
+	return TEXT("FInputBindingPlanCache");
+}
+
+void FInputBindingPlanCache::CompilePlan(FInputBindingPlan& Plan, const FInputActionSettings& ActionSettings, const bool bAllowLoad)
+{
+	UClass* const OwnerClass = Plan.OwnerClass;
+	if (!IsValid(OwnerClass)) { return; }
+
+	// cooked settings carry an already validated flat table
+	if (ActionSettings.CompiledBindings.IsCompiled())
+	{
+		CompilePlanFromTable(Plan, ActionSettings.CompiledBindings, bAllowLoad);
+		return;
+	}
+
+	for (const auto& [ActionInput, FunctionBindingData] : ActionSettings.ActionsBindings)
+	{
+		// Check if the action input is valid
+		if (ActionInput.IsNull())
+		{
+			UE_LOG(LogInputSettings, Error, TEXT("%s: Action Input is null."), *FString(__FUNCTION__));
+			continue;
+		}
+
+		UInputAction* const InputAction = bAllowLoad ? UInputSettingFuncLib::ResolveSoftObject(ActionInput) : ActionInput.Get();
+		if (!IsValid(InputAction))
+		{
+			UE_LOG(LogInputSettings, Error, TEXT("%s: Failed to load Action Input %s."), *FString(__FUNCTION__), *ActionInput.ToString());
+			continue;
+		}
+
+		for (const auto& [FunctionName, Triggers, bPreferNativeBinding] : FunctionBindingData)
+		{
+			// resolved once per owner class instead of once per trigger of every bound object
+			const TSharedPtr<const FInputNativeBinder> NativeBinder = bPreferNativeBinding
+				                                                          ? FInputNativeBindingRegistry::Get().Find(OwnerClass, FunctionName)
+				                                                          : nullptr;
+			UFunction* const Function = OwnerClass->FindFunctionByName(FunctionName);
+			if (Function == nullptr && !NativeBinder.IsValid())
+			{
+				UE_LOG(LogInputSettings, Error, TEXT("%s: Function %s not found on %s."), *FString(__FUNCTION__),
+				       *FunctionName.ToString(), *OwnerClass->GetName());
+				continue;
+			}
+
+			for (const ETriggerEvent& Trigger : Triggers)
+			{
+				Plan.Add(InputAction, Function, Trigger, NativeBinder);
+			}
+		}
+	}
+}
+
+void FInputBindingPlanCache::CompilePlanFromTable(FInputBindingPlan& Plan, const FCompiledInputBindingTable& Table, const bool bAllowLoad)
+{
+	UClass* const OwnerClass = Plan.OwnerClass;
+
+	TArray<UInputAction*, TInlineAllocator<16>> ResolvedActions;
+	ResolvedActions.Reserve(Table.Actions.Num());
+	for (const FSoftObjectPath& ActionPath : Table.Actions)
+	{
+		UObject* LoadedAction = ActionPath.ResolveObject();
+		if (LoadedAction == nullptr && bAllowLoad)
+		{
+			INPUTSETTINGS_SCOPE_CYCLE_COUNTER(STAT_InputSettings_SyncLoad);
+			LoadedAction = ActionPath.TryLoad();
+		}
+		ResolvedActions.Add(Cast<UInputAction>(LoadedAction));
+	}
+
+	for (const auto& [ActionIndex, FunctionName, TriggerMask, bPreferNativeBinding] : Table.Bindings)
+	{
+		UInputAction* const InputAction = ResolvedActions[ActionIndex];
+		if (InputAction == nullptr) { continue; }
+
+		const TSharedPtr<const FInputNativeBinder> NativeBinder = bPreferNativeBinding
+			                                                          ? FInputNativeBindingRegistry::Get().Find(OwnerClass, FunctionName)
+			                                                          : nullptr;
+		UFunction* const Function = OwnerClass->FindFunctionByName(FunctionName);
+		if (Function == nullptr && !NativeBinder.IsValid())
+		{
+			// the cook could only verify functions of the target pawn class
+			UE_LOG(LogInputSettings, Error, TEXT("%s: Function %s not found on %s."), *FString(__FUNCTION__),
+			       *FunctionName.ToString(), *OwnerClass->GetName());
+			continue;
+		}
+
+		for (uint8 TriggerBit = 1; TriggerBit != 0 && TriggerBit <= TriggerMask; TriggerBit <<= 1)
+		{
+			if ((TriggerMask & TriggerBit) != 0)
+			{
+				Plan.Add(InputAction, Function, static_cast<ETriggerEvent>(TriggerBit), NativeBinder);
+			}
+		}
+	}
+}
+
+void FInputBindingPlanCache::HandleReloadComplete(EReloadCompleteReason Reason)
+{
+	InvalidateAll();
+}
+
+#if WITH_EDITOR
+void FInputBindingPlanCache::HandleObjectsReplaced(const TMap<UObject*, UObject*>& ReplacementMap)
+{
+	InvalidateAll();
+}
+#endif
@@ -1,31 +1,167 @@
 ﻿#include "Libs/UInputSettingFuncLib.h"
 
-UEnhancedInputLocalPlayerSubsystem* UInputSettingFuncLib::GetEnhancedInputSubSystemFromActor(AActor* TargetActor)
+#include "Engine/AssetManager.h"
+#include "Engine/LocalPlayer.h"
+#include "InputAction.h"
+#include "InputSettingsStats.h"
+#include "Libs/InputBindingPlanCache.h"
+#include "Libs/InputLatencyTracker.h"
+
+namespace InputSettingFuncLib
 {
-	APawn* TargetPawn = Cast<APawn>(TargetActor);
-	if (!IsValid(TargetPawn)) { return nullptr; }
+	/* Input objects of a pawn, valid as long as the controller, its player and its input component are the ones resolved against */
+	struct FResolvedInput
+	{
+		TObjectKey<AController> Controller;
+		TObjectKey<UPlayer> Player;
+		TObjectKey<UInputComponent> SourceComponent;
+		TWeakObjectPtr<UEnhancedInputLocalPlayerSubsystem> Subsystem;
+		TWeakObjectPtr<UEnhancedInputComponent> InputComponent;
+		bool bResolved = false;
+	};
+
+	TMap<TObjectKey<APawn>, FResolvedInput> ResolvedInputs;
+	int32 ResolvedInputsPruneSize = 64;
+
+	void PruneResolvedInputs()
+	{
+		for (auto It = ResolvedInputs.CreateIterator(); It; ++It)
+		{
+			if (It.Key().ResolveObjectPtr() == nullptr)
+			{
+				It.RemoveCurrent();
+			}
+		}
+		ResolvedInputsPruneSize = FMath::Max(64, ResolvedInputs.Num() * 2);
+	}
 
-	if (const APlayerController* const PlayerController = Cast<APlayerController>(TargetPawn->GetController()))
+	/* Reference counted add or remove through the player's registry, into the caller's batch or committed on its own */
+	void ModifyMappingContext(UEnhancedInputLocalPlayerSubsystem* Subsystem, const UInputMappingContext* MappingContext, const int32 Priority,
+	                          const bool bAdd, FInputMappingContextBatch* MappingBatch)
 	{
-		// only add inputs to local player
-		if (!PlayerController->IsLocalController()) { return nullptr; }
+		FInputMappingContextBatch SingleBatch;
+		FInputMappingContextBatch& TargetBatch = MappingBatch != nullptr ? *MappingBatch : SingleBatch;
+		if (MappingBatch == nullptr)
+		{
+			UInputMappingContextRegistry::BeginMappingContextBatch(SingleBatch);
+		}
+
+		if (bAdd) { UInputMappingContextRegistry::BatchAddMappingContext(TargetBatch, Subsystem, MappingContext, Priority); }
+		else { UInputMappingContextRegistry::BatchRemoveMappingContext(TargetBatch, Subsystem, MappingContext, Priority); }
+
+		if (MappingBatch == nullptr)
+		{
+			UInputMappingContextRegistry::CommitMappingContextBatch(SingleBatch);
+		}
+	}
+
+	/*
+	 * Call a planned handler with the arguments of FEnhancedInputActionHandlerDynamicSignature, in order.
+	 * Handlers may take only the leading ones, a parameter of another type is left at its default.
+	 */
+	void ProcessPlannedFunction(UObject& FunctionOwner, UFunction& Function, const FInputActionInstance& ActionInstance)
+	{
+		uint8* const Parms = static_cast<uint8*>(FMemory_Alloca_Aligned(Function.ParmsSize, Function.GetMinAlignment()));
+		FMemory::Memzero(Parms, Function.ParmsSize);
 
-		if (const ULocalPlayer* const LocalPlayer = PlayerController->GetLocalPlayer())
+		int32 NumArguments = 0;
+		for (TFieldIterator<FProperty> It(&Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
 		{
-			// Get subsystem of the local player and check 
-			UEnhancedInputLocalPlayerSubsystem* const Subsystem = LocalPlayer->GetSubsystem<UEnhancedInputLocalPlayerSubsystem>();
-			if (!IsValid(Subsystem))
+			FProperty* const Property = *It;
+			Property->InitializeValue_InContainer(Parms);
+			if (Property->HasAnyPropertyFlags(CPF_ReturnParm)) { continue; }
+
+			void* const Value = Property->ContainerPtrToValuePtr<void>(Parms);
+			const int32 Argument = NumArguments++;
+			if (Argument == 0)
+			{
+				if (const FStructProperty* const StructProperty = CastField<FStructProperty>(Property);
+					StructProperty != nullptr && StructProperty->Struct == FInputActionValue::StaticStruct())
+				{
+					*static_cast<FInputActionValue*>(Value) = ActionInstance.GetValue();
+				}
+			}
+			else if (Argument == 1 || Argument == 2)
+			{
+				// blueprint functions take doubles
+				if (const FNumericProperty* const NumericProperty = CastField<FNumericProperty>(Property);
+					NumericProperty != nullptr && NumericProperty->IsFloatingPoint())
+				{
+					NumericProperty->SetFloatingPointPropertyValue(Value, Argument == 1 ? ActionInstance.GetElapsedTime() : ActionInstance.GetTriggeredTime());
+				}
+			}
+			else if (Argument == 3)
 			{
-				UE_LOG(LogTemp, Error, TEXT("%s: LocalPlayer %s has no EnhancedInputLocalPlayerSubsystem."),
-				       *FString(__FUNCTION__), *LocalPlayer->GetName());
-				return nullptr;
+				if (const FObjectPropertyBase* const ObjectProperty = CastField<FObjectPropertyBase>(Property);
+					ObjectProperty != nullptr && UInputAction::StaticClass()->IsChildOf(ObjectProperty->PropertyClass))
+				{
+					ObjectProperty->SetObjectPropertyValue(Value, const_cast<UInputAction*>(ActionInstance.GetSourceAction()));
+				}
 			}
+		}
+
+		FunctionOwner.ProcessEvent(&Function, Parms);
 
-			return Subsystem;
+		for (TFieldIterator<FProperty> It(&Function); It && It->HasAnyPropertyFlags(CPF_Parm); ++It)
+		{
+			It->DestroyValue_InContainer(Parms);
 		}
 	}
 
-	return nullptr;
+	const FResolvedInput& ResolveInput(APawn& Pawn)
+	{
+		AController* const Controller = Pawn.GetController();
+		const APlayerController* const PlayerController = Cast<APlayerController>(Controller);
+		UPlayer* const Player = PlayerController != nullptr ? PlayerController->Player.Get() : nullptr;
+		UInputComponent* const SourceComponent = Controller != nullptr ? Controller->InputComponent.Get() : nullptr;
+
+		FResolvedInput& Resolved = ResolvedInputs.FindOrAdd(&Pawn);
+		if (Resolved.bResolved && Resolved.Controller == TObjectKey<AController>(Controller) && Resolved.Player == TObjectKey<UPlayer>(Player)
+			&& Resolved.SourceComponent == TObjectKey<UInputComponent>(SourceComponent))
+		{
+			return Resolved;
+		}
+
+		// possession, player swap or a new input component, walk the chain once and keep the result
+		Resolved.Controller = Controller;
+		Resolved.Player = Player;
+		Resolved.SourceComponent = SourceComponent;
+		Resolved.Subsystem = nullptr;
+		Resolved.InputComponent = Cast<UEnhancedInputComponent>(SourceComponent);
+		Resolved.bResolved = true;
+
+		// only add inputs to local player
+		if (PlayerController != nullptr && PlayerController->IsLocalController())
+		{
+			if (const ULocalPlayer* const LocalPlayer = Cast<ULocalPlayer>(Player))
+			{
+				// Get subsystem of the local player and check 
+				Resolved.Subsystem = LocalPlayer->GetSubsystem<UEnhancedInputLocalPlayerSubsystem>();
+				if (!Resolved.Subsystem.IsValid())
+				{
+					UE_LOG(LogInputSettings, Error, TEXT("%s: LocalPlayer %s has no EnhancedInputLocalPlayerSubsystem."),
+					       *FString(__FUNCTION__), *LocalPlayer->GetName());
+				}
+			}
+		}
+
+		if (ResolvedInputs.Num() > ResolvedInputsPruneSize)
+		{
+			// Resolved may move while pruning, the pawn's entry survives it
+			PruneResolvedInputs();
+			return ResolvedInputs.FindChecked(&Pawn);
+		}
+
+		return Resolved;
+	}
+}
+
+UEnhancedInputLocalPlayerSubsystem* UInputSettingFuncLib::GetEnhancedInputSubSystemFromActor(AActor* TargetActor)
+{
+	APawn* TargetPawn = Cast<APawn>(TargetActor);
+	if (!IsValid(TargetPawn)) { return nullptr; }
+
+	return InputSettingFuncLib::ResolveInput(*TargetPawn).Subsystem.Get();
 }
 
 UEnhancedInputComponent* UInputSettingFuncLib::GetInputComponentFromActor(AActor* TargetActor)
@@ -33,7 +169,12 @@ UEnhancedInputComponent* UInputSettingFuncLib::GetInputComponentFromActor(AActor
 	APawn* TargetPawn = Cast<APawn>(TargetActor);
 	if (!IsValid(TargetPawn)) { return nullptr; }
 
-	return Cast<UEnhancedInputComponent>(TargetPawn->GetController()->InputComponent.Get());
+	return InputSettingFuncLib::ResolveInput(*TargetPawn).InputComponent.Get();
+}
+
+void UInputSettingFuncLib::InvalidateResolvedInput(const APawn* TargetPawn)
+{
+	InputSettingFuncLib::ResolvedInputs.Remove(TargetPawn);
 }
 
 UObject* UInputSettingFuncLib::GetInputOwnerObject(UObject* InObject, const EInputBindingOwnerOverride& InOwner)
@@ -51,21 +192,25 @@ UObject* UInputSettingFuncLib::GetInputOwnerObject(UObject* InObject, const EInp
 		{
 			return InPawn->GetController();
 		}
-		UE_LOG(LogTemp, Error, TEXT("%s's controller - Invalid InputBinding Owner."), *InObject->GetName());
+		UE_LOG(LogInputSettings, Error, TEXT("%s's controller - Invalid InputBinding Owner."), *InObject->GetName());
 		return nullptr;
 	}
 
 	return nullptr;
 }
 
-TArray<FInputBindingHandle> UInputSettingFuncLib::AddActorInputs(AActor* TargetActor, const FInputActionSettings& ActionSettings)
+TArray<FInputBindingHandle> UInputSettingFuncLib::AddActorInputs(AActor* TargetActor, const FInputActionSettings& ActionSettings,
+                                                                 FInputMappingContextBatch* MappingBatch)
 {
-	return AddActorInputs(TargetActor, GetInputOwnerObject(TargetActor, ActionSettings.InputBindingOwner), ActionSettings);
+	return AddActorInputs(TargetActor, GetInputOwnerObject(TargetActor, ActionSettings.InputBindingOwner), ActionSettings, MappingBatch);
 }
 
 TArray<FInputBindingHandle> UInputSettingFuncLib::AddActorInputs(AActor* TargetActor, UObject* BoundFuncSource,
-                                                                 const FInputActionSettings& ActionSettings)
+                                                                 const FInputActionSettings& ActionSettings,
+                                                                 FInputMappingContextBatch* MappingBatch)
 {
+	INPUTSETTINGS_SCOPE_CYCLE_COUNTER(STAT_InputSettings_AddActorInputs);
+
 	TArray<FInputBindingHandle> OutHandles;
 
 	APawn* const TargetPawn = Cast<APawn>(TargetActor);
@@ -75,112 +220,300 @@ TArray<FInputBindingHandle> UInputSettingFuncLib::AddActorInputs(AActor* TargetA
 	if (UEnhancedInputLocalPlayerSubsystem* const Subsystem = GetEnhancedInputSubSystemFromActor(TargetPawn))
 	{
 		// load and store input mapping context
-		UInputMappingContext* const InputMapping = ActionSettings.InputMappingContext.LoadSynchronous();
+		UInputMappingContext* const InputMapping = ResolveSoftObject(ActionSettings.InputMappingContext);
+		if (!IsValid(InputMapping))
+		{
+			UE_LOG(LogInputSettings, Error, TEXT("%s: Failed to load Input Mapping Context for Actor %s."), *FString(__FUNCTION__),
+			       *TargetActor->GetName());
+			return OutHandles;
+		}
 
-		UE_LOG(LogTemp, Warning, TEXT("%s: Adding Enhanced Input Mapping %s to Actor %s."), *FString(__FUNCTION__),
+		UE_LOG(LogInputSettings, Verbose, TEXT("%s: Adding Enhanced Input Mapping %s to Actor %s."), *FString(__FUNCTION__),
 		       *InputMapping->GetName(), *TargetActor->GetName());
 
-		// Add the loaded mapping context into the enhanced input subsystem
-		Subsystem->AddMappingContext(InputMapping, ActionSettings.MappingPriority);
+		// Add the loaded mapping context into the enhanced input subsystem, or defer it to the caller's batch
+		InputSettingFuncLib::ModifyMappingContext(Subsystem, InputMapping, ActionSettings.MappingPriority, true, MappingBatch);
 
 		if (!IsValid(BoundFuncSource))
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s: Failed to get the function owner using the Actor %s."),
+			UE_LOG(LogInputSettings, Error, TEXT("%s: Failed to get the function owner using the Actor %s."),
 			       *FString(__FUNCTION__), *TargetActor->GetName());
 			return OutHandles;
 		}
 
 		// Get the Enhanced Input component of the target Pawn and check 
-		const TWeakObjectPtr<UEnhancedInputComponent> InputComponent = Cast<UEnhancedInputComponent>(
-			TargetPawn->GetController()->InputComponent.Get());
-		if (!InputComponent.IsValid())
+		if (!IsValid(GetInputComponentFromActor(TargetPawn)))
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s: Failed to find InputComponent on Actor %s."), *FString(__FUNCTION__),
+			UE_LOG(LogInputSettings, Error, TEXT("%s: Failed to find InputComponent on Actor %s."), *FString(__FUNCTION__),
 			       *TargetActor->GetName());
 			return OutHandles;
 		}
 
 		// setup the action bindings and add the extension to the active map
-		SetupInputBindings(TargetActor, BoundFuncSource, ActionSettings);
+		OutHandles = SetupInputBindings(TargetActor, BoundFuncSource, ActionSettings);
 	}
 	else if (TargetPawn->IsPawnControlled())
 	{
-		UE_LOG(LogTemp, Error, TEXT("%s: Failed to find PlayerController on Actor %s."), *FString(__FUNCTION__),
+		UE_LOG(LogInputSettings, Error, TEXT("%s: Failed to find PlayerController on Actor %s."), *FString(__FUNCTION__),
 		       *TargetActor->GetName());
 	}
 
 	return OutHandles;
 }
 
-bool UInputSettingFuncLib::RemoveActorInputs(AActor* TargetActor, const TArray<FInputBindingHandle>& BindingHandles,
-                                             const UInputMappingContext* MappingContext)
+bool UInputSettingFuncLib::RemoveActorInputs(AActor* TargetActor, TConstArrayView<FInputBindingHandle> BindingHandles,
+                                             const UInputMappingContext* MappingContext, const int32 MappingPriority,
+                                             FInputMappingContextBatch* MappingBatch)
 {
 	bool bRemoveActionSucceeded = true;
 
-	// Try to get the enhanced input subsystem from the pawn
-	if (UEnhancedInputLocalPlayerSubsystem* const Subsystem = GetEnhancedInputSubSystemFromActor(TargetActor))
+	// Try to get the enhanced input subsystem and the enhanced input component of the target pawn
+	UEnhancedInputLocalPlayerSubsystem* const Subsystem = GetEnhancedInputSubSystemFromActor(TargetActor);
+	UEnhancedInputComponent* const InputComponent = IsValid(Subsystem) ? GetInputComponentFromActor(TargetActor) : nullptr;
+	if (IsValid(Subsystem))
 	{
-		UE_LOG(LogTemp, Warning, TEXT("%s: Removing Enhanced Input Mapping %s from Actor %s."),
-		       *FString(__FUNCTION__), *MappingContext->GetName(), *TargetActor->GetName());
+		UE_LOG(LogInputSettings, Verbose, TEXT("%s: Removing Enhanced Input Mapping %s from Actor %s."),
+		       *FString(__FUNCTION__), *GetNameSafe(MappingContext), *TargetActor->GetName());
 
-		// Try to get the enhanced input component of the target pawn
-		UEnhancedInputComponent* InputComponent = GetInputComponentFromActor(TargetActor);
 		if (!IsValid(InputComponent))
-
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s: Failed to find InputComponent on Actor %s."),
+			UE_LOG(LogInputSettings, Error, TEXT("%s: Failed to find InputComponent on Actor %s."),
 			       *FString(__FUNCTION__), *TargetActor->GetName());
 
 			bRemoveActionSucceeded = false;
 		}
-		else
+	}
+
+	RemoveResolvedInputs(Subsystem, InputComponent, BindingHandles, MappingContext, MappingPriority, MappingBatch);
+	return bRemoveActionSucceeded;
+}
+
+void UInputSettingFuncLib::RemoveResolvedInputs(UEnhancedInputLocalPlayerSubsystem* Subsystem, UEnhancedInputComponent* InputComponent,
+                                                TConstArrayView<FInputBindingHandle> BindingHandles, const UInputMappingContext* MappingContext,
+                                                const int32 MappingPriority, FInputMappingContextBatch* MappingBatch)
+{
+	INPUTSETTINGS_SCOPE_CYCLE_COUNTER(STAT_InputSettings_RemoveActorInputs);
+
+	// the handles are dropped by the caller either way, so they stop counting as live here
+	DEC_DWORD_STAT_BY(STAT_InputSettings_LiveBindings, BindingHandles.Num());
+
+	// without a subsystem the actor was never bound, nothing to release
+	if (!IsValid(Subsystem)) { return; }
+
+	// Iterate through the active bindings and remove all, a destroyed pawn took its own input component and bindings along
+	if (IsValid(InputComponent))
+	{
+		for (const FInputBindingHandle& Handle : BindingHandles)
 		{
-			// Iterate through the active bindings and remove all
-			for (const FInputBindingHandle& Handle : BindingHandles)
+			InputComponent->RemoveBinding(Handle);
+		}
+	}
+
+	// Remove the mapping context from the subsystem, or defer it to the caller's batch
+	InputSettingFuncLib::ModifyMappingContext(Subsystem, MappingContext, MappingPriority, false, MappingBatch);
+}
+
+bool UInputSettingFuncLib::UpdateActorInputs(AActor* TargetActor, TConstArrayView<FInputBindingHandle> BindingHandles,
+                                             const FInputActionSettings& OldSettings, const FInputActionSettings& NewSettings,
+                                             TArray<FInputBindingHandle>& OutHandles, FInputMappingContextBatch* MappingBatch)
+{
+	UEnhancedInputLocalPlayerSubsystem* const Subsystem = GetEnhancedInputSubSystemFromActor(TargetActor);
+	if (!IsValid(Subsystem)) { return false; }
+
+	UEnhancedInputComponent* const InputComponent = GetInputComponentFromActor(TargetActor);
+	if (!IsValid(InputComponent)) { return false; }
+
+	// mapping context swap, a priority change goes through the same remove/add so the subsystem re-sorts it
+	if (OldSettings.InputMappingContext != NewSettings.InputMappingContext || OldSettings.MappingPriority != NewSettings.MappingPriority)
+	{
+		const UInputMappingContext* const OldMapping = OldSettings.InputMappingContext.Get();
+		const UInputMappingContext* const NewMapping = NewSettings.InputMappingContext.IsNull()
+			                                               ? nullptr
+			                                               : ResolveSoftObject(NewSettings.InputMappingContext);
+
+		InputSettingFuncLib::ModifyMappingContext(Subsystem, OldMapping, OldSettings.MappingPriority, false, MappingBatch);
+		InputSettingFuncLib::ModifyMappingContext(Subsystem, NewMapping, NewSettings.MappingPriority, true, MappingBatch);
+	}
+
+	UObject* const OldOwner = GetInputOwnerObject(TargetActor, OldSettings.InputBindingOwner);
+	UObject* const NewOwner = GetInputOwnerObject(TargetActor, NewSettings.InputBindingOwner);
+
+	FInputBindingPlanCache& PlanCache = FInputBindingPlanCache::Get();
+	const TSharedRef<const FInputBindingPlan> NewPlan = PlanCache.FindOrCompile(IsValid(NewOwner) ? NewOwner->GetClass() : nullptr, NewSettings);
+	const TSharedRef<const FInputBindingPlan> OldPlan = PlanCache.FindOrCompile(IsValid(OldOwner) ? OldOwner->GetClass() : nullptr, OldSettings);
+
+	// handles only map back to bindings when they were made against the same owner from the same plan
+	const bool bCanReuseHandles = IsValid(NewOwner) && OldOwner == NewOwner && OldPlan->Num() == BindingHandles.Num();
+
+	TArray<bool, TInlineAllocator<32>> ReusedHandles;
+	ReusedHandles.SetNumZeroed(BindingHandles.Num());
+
+	int32 NumAddedBindings = 0;
+	OutHandles.Reset(NewPlan->Num());
+	for (int32 NewIndex = 0; NewIndex < NewPlan->Num(); ++NewIndex)
+	{
+		int32 ReusedIndex = INDEX_NONE;
+		for (int32 OldIndex = 0; bCanReuseHandles && OldIndex < OldPlan->Num(); ++OldIndex)
+		{
+			if (!ReusedHandles[OldIndex] && NewPlan->IsSameBinding(NewIndex, *OldPlan, OldIndex))
 			{
-				InputComponent->RemoveBinding(Handle);
+				ReusedIndex = OldIndex;
+				break;
 			}
 		}
 
-		// Remove the mapping context from the subsystem
-		Subsystem->RemoveMappingContext(MappingContext);
+		if (ReusedIndex != INDEX_NONE)
+		{
+			ReusedHandles[ReusedIndex] = true;
+			OutHandles.Add(BindingHandles[ReusedIndex]);
+		}
+		else
+		{
+			OutHandles.Add(BindPlannedAction(*InputComponent, *NewPlan, NewIndex, NewOwner));
+			++NumAddedBindings;
+		}
 	}
 
-	return bRemoveActionSucceeded;
+	// whatever the new plan didn't claim is gone from the settings
+	int32 NumRemovedBindings = 0;
+	for (int32 OldIndex = 0; OldIndex < BindingHandles.Num(); ++OldIndex)
+	{
+		if (!ReusedHandles[OldIndex])
+		{
+			InputComponent->RemoveBinding(BindingHandles[OldIndex]);
+			++NumRemovedBindings;
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_InputSettings_LiveBindings, NumAddedBindings);
+	DEC_DWORD_STAT_BY(STAT_InputSettings_LiveBindings, NumRemovedBindings);
+
+	UE_LOG(LogInputSettings, Verbose, TEXT("%s: Actor %s, %d bindings added, %d removed, %d kept."), *FString(__FUNCTION__),
+	       *TargetActor->GetName(), NumAddedBindings, NumRemovedBindings, OutHandles.Num() - NumAddedBindings);
+
+	return true;
 }
 
-TArray<FInputBindingHandle> UInputSettingFuncLib::SetupInputBindings(AActor* InActor, UObject* FunctionOwner,
-                                                                     const FInputActionSettings& ActionSettings)
+void UInputSettingFuncLib::GetInputSettingsAssetPaths(const FInputActionSettings& ActionSettings, TArray<FSoftObjectPath>& OutPaths)
 {
-	TArray<FInputBindingHandle> OutArr;
+	if (!ActionSettings.InputMappingContext.IsNull())
+	{
+		OutPaths.AddUnique(ActionSettings.InputMappingContext.ToSoftObjectPath());
+	}
 
-	UEnhancedInputComponent* InputComponent = GetInputComponentFromActor(InActor);
+	// already unique and non null
+	if (ActionSettings.CompiledBindings.IsCompiled())
+	{
+		OutPaths.Append(ActionSettings.CompiledBindings.Actions);
+		return;
+	}
 
-	// Iterate through the bindings to add all
-	for (const auto& [ActionInput,FunctionBindingData] : ActionSettings.ActionsBindings)
+	for (const FInputMappingStack& MappingStack : ActionSettings.ActionsBindings)
 	{
-		// Check if the action input is valid
-		if (ActionInput.IsNull())
+		if (!MappingStack.ActionInput.IsNull())
 		{
-			UE_LOG(LogTemp, Error, TEXT("%s: Action Input is null."), *FString(__FUNCTION__));
-			continue;
+			OutPaths.AddUnique(MappingStack.ActionInput.ToSoftObjectPath());
 		}
+	}
+}
 
-		// Load and store the Action
-		UInputAction* const InputAction = ActionInput.LoadSynchronous();
+bool UInputSettingFuncLib::IsInputSettingsLoaded(const FInputActionSettings& ActionSettings)
+{
+	if (!ActionSettings.InputMappingContext.IsNull() && !ActionSettings.InputMappingContext.IsValid()) { return false; }
 
-		UE_LOG(LogTemp, Warning, TEXT("%s: Binding Action Input %s to Actor %s."), *FString(__FUNCTION__),
-		       *InputAction->GetName(), *InActor->GetName());
+	for (const FInputMappingStack& MappingStack : ActionSettings.ActionsBindings)
+	{
+		if (!MappingStack.ActionInput.IsNull() && !MappingStack.ActionInput.IsValid()) { return false; }
+	}
+
+	return true;
+}
 
-		// Iterate through all function binding data to bind the UFunctions to it's corresponding input
-		for (const auto& [FunctionName, Triggers] : FunctionBindingData)
+TSharedPtr<FStreamableHandle> UInputSettingFuncLib::RequestAsyncLoadInputSettings(const FInputActionSettings& ActionSettings,
+                                                                                  FStreamableDelegate OnLoaded)
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	GetInputSettingsAssetPaths(ActionSettings, AssetPaths);
+	if (AssetPaths.IsEmpty()) { return nullptr; }
+
+	return UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(AssetPaths), MoveTemp(OnLoaded));
+}
+
+TSharedPtr<FStreamableHandle> UInputSettingFuncLib::AddActorInputsAsync(AActor* TargetActor, const FInputActionSettings& ActionSettings,
+                                                                       FOnActorInputsAdded OnInputsAdded)
+{
+	if (!IsValid(TargetActor)) { return nullptr; }
+
+	// everything already in memory, no need to go through the streamable manager
+	if (IsInputSettingsLoaded(ActionSettings))
+	{
+		const TArray<FInputBindingHandle> BindingHandles = AddActorInputs(TargetActor, ActionSettings);
+		OnInputsAdded.ExecuteIfBound(BindingHandles);
+		return nullptr;
+	}
+
+	// the settings are copied, the caller's struct is not guaranteed to outlive the request
+	const FStreamableDelegate LoadedDelegate = FStreamableDelegate::CreateLambda(
+		[WeakActor = TWeakObjectPtr<AActor>(TargetActor), ActionSettings, OnInputsAdded]()
 		{
-			// Iterate through all triggersto bind the UFunctions to it's corresponding trigger type
-			for (const ETriggerEvent& Trigger : Triggers)
-			{
-				OutArr.Add(InputComponent->BindAction(InputAction, Trigger, FunctionOwner, FunctionName));
-			}
-		}
+			AActor* const LoadedActor = WeakActor.Get();
+			if (!IsValid(LoadedActor)) { return; }
+
+			const TArray<FInputBindingHandle> BindingHandles = AddActorInputs(LoadedActor, ActionSettings);
+			OnInputsAdded.ExecuteIfBound(BindingHandles);
+		});
+
+	return RequestAsyncLoadInputSettings(ActionSettings, LoadedDelegate);
+}
+
+TArray<FInputBindingHandle> UInputSettingFuncLib::SetupInputBindings(AActor* InActor, UObject* FunctionOwner,
+                                                                     const FInputActionSettings& ActionSettings)
+{
+	INPUTSETTINGS_SCOPE_CYCLE_COUNTER(STAT_InputSettings_SetupInputBindings);
+
+	TArray<FInputBindingHandle> OutArr;
+
+	UEnhancedInputComponent* InputComponent = GetInputComponentFromActor(InActor);
+	if (!IsValid(InputComponent) || !IsValid(FunctionOwner)) { return OutArr; }
+
+	// actions and functions are resolved once per owner class, binding is a flat walk over the plan
+	const TSharedRef<const FInputBindingPlan> Plan = FInputBindingPlanCache::Get().FindOrCompile(FunctionOwner->GetClass(), ActionSettings);
+
+	OutArr.Reserve(Plan->Num());
+	for (int32 Index = 0; Index < Plan->Num(); ++Index)
+	{
+		UE_LOG(LogInputSettings, Verbose, TEXT("%s: Binding Action Input %s to Actor %s."), *FString(__FUNCTION__),
+		       *Plan->Actions[Index]->GetName(), *InActor->GetName());
+
+		OutArr.Add(BindPlannedAction(*InputComponent, *Plan, Index, FunctionOwner));
 	}
+
+	INC_DWORD_STAT_BY(STAT_InputSettings_LiveBindings, OutArr.Num());
 	return OutArr;
 }
+
+FInputBindingHandle UInputSettingFuncLib::BindPlannedAction(UEnhancedInputComponent& InputComponent, const FInputBindingPlan& Plan,
+                                                            const int32 Index, UObject* FunctionOwner)
+{
+	const UInputAction* const InputAction = Plan.Actions[Index];
+	const ETriggerEvent Trigger = Plan.Triggers[Index];
+
+	// registered native handler, a plain member function delegate like the ones bound in SetupPlayerInputComponent
+	if (const TSharedPtr<const FInputNativeBinder>& NativeBinder = Plan.NativeBinders[Index])
+	{
+		return (*NativeBinder)(InputComponent, InputAction, Trigger, FunctionOwner);
+	}
+
+	// the planned UFunction is called as is, the dynamic delegate BindAction creates would look it up by name on every event
+	return InputComponent.BindActionInstanceLambda(InputAction, Trigger,
+		[WeakOwner = TWeakObjectPtr<UObject>(FunctionOwner), WeakFunction = TWeakObjectPtr<UFunction>(Plan.Functions[Index])](
+		const FInputActionInstance& ActionInstance)
+		{
+			UObject* const Owner = WeakOwner.Get();
+			UFunction* const Function = WeakFunction.Get();
+			if (Owner == nullptr || Function == nullptr) { return; }
+
+			const FInputLatencyTracker::FDispatchScope LatencyScope(EInputLatencySource::Reflected);
+			InputSettingFuncLib::ProcessPlannedFunction(*Owner, *Function, ActionInstance);
+		});
+}
@@ -0,0 +1,192 @@
+﻿#include "Subsystems/InputExtensionDispatcher.h"
+
+#include "Actions/GameFeatureAction_AddInputs.h"
+#include "Components/GameFrameworkComponentManager.h"
+#include "Engine/GameInstance.h"
+#include "GameFramework/Pawn.h"
+#include "GameplayTagAssetInterface.h"
+#include "InputSettingsStats.h"
+#include "Libs/UInputSettingFuncLib.h"
+#include "Types/InputTagQuery.h"
+
+void UInputExtensionDispatcher::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UGameFrameworkComponentManager>();
+
+	GetGameInstance()->OnPawnControllerChangedDelegates.AddDynamic(this, &ThisClass::HandlePawnControllerChanged);
+}
+
+void UInputExtensionDispatcher::Deinitialize()
+{
+	GetGameInstance()->OnPawnControllerChangedDelegates.RemoveDynamic(this, &ThisClass::HandlePawnControllerChanged);
+
+	CachedOwnedTagsHashes.Reset();
+
+	// released outside the map, the component manager sends removal events while unregistering
+	TMap<TSoftClassPtr<APawn>, FClassListeners> ReleasedListeners = MoveTemp(ClassListeners);
+	ClassListeners.Reset();
+	ReleasedListeners.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UInputExtensionDispatcher::AddListener(UGameFeatureAction_AddInputs* Action, const TSoftClassPtr<APawn>& PawnClass)
+{
+	if (!IsValid(Action) || PawnClass.IsNull()) { return false; }
+
+	if (FClassListeners* const Listeners = ClassListeners.Find(PawnClass))
+	{
+		if (Listeners->Actions.Contains(Action)) { return true; }
+		Listeners->Actions.Add(Action);
+
+		// the component manager only extends existing actors when a handler registers, catch the new listener up
+		TArray<TWeakObjectPtr<AActor>> ExtendedActors = Listeners->ExtendedActors.Array();
+		for (const TWeakObjectPtr<AActor>& ExtendedActor : ExtendedActors)
+		{
+			if (AActor* const Actor = ExtendedActor.Get(); IsValid(Actor))
+			{
+				FInputExtensionEvent Event;
+				Event.Actor = Actor;
+				Event.bAddInputs = true;
+				Event.Subsystem = UInputSettingFuncLib::GetEnhancedInputSubSystemFromActor(Actor);
+				Event.TagsHash = GetActorTagsHash(Actor);
+				Action->HandleExtensionEvent(Event);
+			}
+		}
+		return true;
+	}
+
+	UGameFrameworkComponentManager* const ComponentManager = UGameInstance::GetSubsystem<UGameFrameworkComponentManager>(GetGameInstance());
+	if (!IsValid(ComponentManager)) { return false; }
+
+	// the listener is in place before registering, existing actors are extended synchronously by AddExtensionHandler
+	ClassListeners.Add(PawnClass).Actions.Add(Action);
+
+	using FHandlerDelegate = UGameFrameworkComponentManager::FExtensionHandlerDelegate;
+	TSharedPtr<FComponentRequestHandle> Request = ComponentManager->AddExtensionHandler(
+		PawnClass, FHandlerDelegate::CreateUObject(this, &ThisClass::HandleActorExtension, PawnClass));
+
+	ClassListeners.FindChecked(PawnClass).Request = MoveTemp(Request);
+	return true;
+}
+
+void UInputExtensionDispatcher::RemoveListener(const UGameFeatureAction_AddInputs* Action)
+{
+	TArray<TSharedPtr<FComponentRequestHandle>> ReleasedRequests;
+
+	for (auto It = ClassListeners.CreateIterator(); It; ++It)
+	{
+		FClassListeners& Listeners = It.Value();
+		Listeners.Actions.RemoveAllSwap([Action](const TWeakObjectPtr<UGameFeatureAction_AddInputs>& Listener)
+		{
+			return !Listener.IsValid() || Listener.Get() == Action;
+		});
+
+		if (Listeners.Actions.IsEmpty())
+		{
+			ReleasedRequests.Add(MoveTemp(Listeners.Request));
+			It.RemoveCurrent();
+		}
+	}
+
+	// removal events sent while unregistering find no listener anymore, the actions clean up their own extensions
+	ReleasedRequests.Reset();
+}
+
+void UInputExtensionDispatcher::GetExtendedActors(const UGameFeatureAction_AddInputs* Action, TArray<AActor*>& OutActors) const
+{
+	for (const TPair<TSoftClassPtr<APawn>, FClassListeners>& Pair : ClassListeners)
+	{
+		if (!Pair.Value.Actions.Contains(Action)) { continue; }
+
+		for (const TWeakObjectPtr<AActor>& ExtendedActor : Pair.Value.ExtendedActors)
+		{
+			if (AActor* const Actor = ExtendedActor.Get(); IsValid(Actor))
+			{
+				OutActors.AddUnique(Actor);
+			}
+		}
+	}
+}
+
+uint32 UInputExtensionDispatcher::GetActorTagsHash(const AActor* Actor)
+{
+	if (!IsValid(Actor)) { return 0; }
+
+	// the names are a plain array on the actor, cheap to hash and without a change notification
+	const uint32 NameTagsHash = FInputTagQuery::GetActorNameTagsHash(Actor);
+
+	// gathering the owned tags builds a container, only done again once the actor's tags were invalidated
+	if (!Actor->Implements<UGameplayTagAssetInterface>()) { return HashCombineFast(NameTagsHash, 0); }
+
+	if (const uint32* const CachedHash = CachedOwnedTagsHashes.Find(Actor))
+	{
+		return HashCombineFast(NameTagsHash, *CachedHash);
+	}
+
+	const uint32 OwnedTagsHash = FInputTagQuery::GetOwnedTagsHash(Actor);
+	CachedOwnedTagsHashes.Add(Actor, OwnedTagsHash);
+	return HashCombineFast(NameTagsHash, OwnedTagsHash);
+}
+
+void UInputExtensionDispatcher::InvalidateActorTags(const AActor* Actor)
+{
+	CachedOwnedTagsHashes.Remove(Actor);
+}
+
+void UInputExtensionDispatcher::HandlePawnControllerChanged(APawn* Pawn, AController* Controller)
+{
+	UInputSettingFuncLib::InvalidateResolvedInput(Pawn);
+}
+
+void UInputExtensionDispatcher::HandleActorExtension(AActor* Owner, const FName EventName, TSoftClassPtr<APawn> PawnClass)
+{
+	FInputExtensionEvent Event;
+	Event.Actor = Owner;
+	if (EventName == UGameFrameworkComponentManager::NAME_ExtensionRemoved || EventName == UGameFrameworkComponentManager::NAME_ReceiverRemoved)
+	{
+		Event.bAddInputs = false;
+	}
+	else if (EventName == UGameFrameworkComponentManager::NAME_ExtensionAdded || EventName == UGameFrameworkComponentManager::NAME_GameActorReady
+		|| EventName == UGameFrameworkComponentManager::NAME_ReceiverAdded)
+	{
+		Event.bAddInputs = true;
+	}
+	else { return; }
+
+	FClassListeners* const Listeners = ClassListeners.Find(PawnClass);
+	if (Listeners == nullptr) { return; }
+
+	if (Event.bAddInputs)
+	{
+		if (!IsValid(Owner)) { return; }
+		Listeners->ExtendedActors.Add(Owner);
+
+		// resolved once here, every listener below reads the same cached lookup
+		Event.Subsystem = UInputSettingFuncLib::GetEnhancedInputSubSystemFromActor(Owner);
+		Event.TagsHash = GetActorTagsHash(Owner);
+	}
+	else
+	{
+		Listeners->ExtendedActors.Remove(Owner);
+		InvalidateActorTags(Owner);
+	}
+
+	// a listener may unregister while handling the event, walk a copy
+	const TArray<TWeakObjectPtr<UGameFeatureAction_AddInputs>, TInlineAllocator<4>> Actions = Listeners->Actions;
+	for (const TWeakObjectPtr<UGameFeatureAction_AddInputs>& Listener : Actions)
+	{
+		if (UGameFeatureAction_AddInputs* const Action = Listener.Get())
+		{
+			Action->HandleExtensionEvent(Event);
+		}
+	}
+
+	if (!Event.bAddInputs)
+	{
+		// every listener released its inputs, the next possession resolves again
+		UInputSettingFuncLib::InvalidateResolvedInput(Cast<APawn>(Owner));
+	}
+}
@@ -0,0 +1,79 @@
+﻿#include "Types/CompiledInputBindingTable.h"
+
+#include "Libs/InputNativeBindingRegistry.h"
+#include "Types/InputSettingStructs.h"
+
+#if WITH_EDITOR
+#include "AssetRegistry/IAssetRegistry.h"
+
+#define LOCTEXT_NAMESPACE "CompiledInputBindingTable"
+
+bool FCompiledInputBindingTable::Build(const FInputActionSettings& ActionSettings, const UClass* OwnerClass, TArray<FText>& OutErrors)
+{
+	Reset();
+	const int32 NumPreviousErrors = OutErrors.Num();
+	const IAssetRegistry* const AssetRegistry = IAssetRegistry::Get();
+
+	for (int32 StackIndex = 0; StackIndex < ActionSettings.ActionsBindings.Num(); ++StackIndex)
+	{
+		const auto& [ActionInput, FunctionBindingData] = ActionSettings.ActionsBindings[StackIndex];
+		if (ActionInput.IsNull())
+		{
+			OutErrors.Add(FText::Format(LOCTEXT("NullAction", "Actions Bindings [{0}] has no input action."), StackIndex));
+			continue;
+		}
+
+		const FSoftObjectPath ActionPath = ActionInput.ToSoftObjectPath();
+		if (AssetRegistry != nullptr && !AssetRegistry->GetAssetByObjectPath(ActionPath).IsValid())
+		{
+			OutErrors.Add(FText::Format(LOCTEXT("MissingAction", "Actions Bindings [{0}] references missing input action {1}."),
+			                            StackIndex, FText::FromString(ActionPath.ToString())));
+			continue;
+		}
+
+		const int32 ActionIndex = Actions.AddUnique(ActionPath);
+
+		for (const auto& [FunctionName, Triggers, bPreferNativeBinding] : FunctionBindingData)
+		{
+			if (FunctionName.IsNone())
+			{
+				OutErrors.Add(FText::Format(LOCTEXT("NoFunction", "Actions Bindings [{0}] has a binding without function name."), StackIndex));
+				continue;
+			}
+
+			if (OwnerClass != nullptr && OwnerClass->FindFunctionByName(FunctionName) == nullptr
+				&& !FInputNativeBindingRegistry::Get().Find(OwnerClass, FunctionName).IsValid())
+			{
+				OutErrors.Add(FText::Format(LOCTEXT("UnknownFunction", "Function {0} bound in Actions Bindings [{1}] does not exist on {2}."),
+				                            FText::FromName(FunctionName), StackIndex, FText::FromString(OwnerClass->GetName())));
+				continue;
+			}
+
+			uint8 TriggerMask = 0;
+			for (const ETriggerEvent Trigger : Triggers)
+			{
+				TriggerMask |= static_cast<uint8>(Trigger);
+			}
+
+			if (TriggerMask == 0)
+			{
+				OutErrors.Add(FText::Format(LOCTEXT("NoTrigger", "Function {0} bound in Actions Bindings [{1}] has no trigger."),
+				                            FText::FromName(FunctionName), StackIndex));
+				continue;
+			}
+
+			Bindings.Add({ActionIndex, FunctionName, TriggerMask, bPreferNativeBinding});
+		}
+	}
+
+	bCompiled = OutErrors.Num() == NumPreviousErrors;
+	if (!bCompiled)
+	{
+		Reset();
+	}
+
+	return bCompiled;
+}
+
+#undef LOCTEXT_NAMESPACE
+#endif
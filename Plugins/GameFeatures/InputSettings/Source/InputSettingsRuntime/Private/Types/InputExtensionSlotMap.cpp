@@ -0,0 +1,206 @@
+﻿#include "Types/InputExtensionSlotMap.h"
+
+#include "InputMappingContext.h"
+
+FInputExtensionId FInputExtensionSlotMap::Add(AActor* Actor, UEnhancedInputLocalPlayerSubsystem* Subsystem, UEnhancedInputComponent* InputComponent,
+                                              UInputMappingContext* Mapping, const int32 MappingPriority, TConstArrayView<FInputBindingHandle> Handles)
+{
+	if (const FInputExtensionId* const ExistingId = ActorIds.Find(Actor))
+	{
+		FEntry& ExistingEntry = Entries[Slots[ExistingId->SlotIndex].Index];
+		ExistingEntry.Subsystem = Subsystem;
+		ExistingEntry.InputComponent = InputComponent;
+		ExistingEntry.Mapping = Mapping;
+		ExistingEntry.MappingPriority = MappingPriority;
+		AppendHandles(*ExistingId, Handles);
+		return *ExistingId;
+	}
+
+	// reuse a free slot before growing
+	int32 SlotIndex = FirstFreeSlot;
+	if (SlotIndex != INDEX_NONE)
+	{
+		FirstFreeSlot = Slots[SlotIndex].Index;
+	}
+	else { SlotIndex = Slots.AddDefaulted(); }
+
+	FSlot& Slot = Slots[SlotIndex];
+	Slot.Index = Entries.Num();
+
+	FEntry& NewEntry = Entries.AddDefaulted_GetRef();
+	NewEntry.Actor = Actor;
+	NewEntry.ActorKey = Actor;
+	NewEntry.Subsystem = Subsystem;
+	NewEntry.InputComponent = InputComponent;
+	NewEntry.Mapping = Mapping;
+	NewEntry.MappingPriority = MappingPriority;
+	NewEntry.HandleStart = HandlePool.Num();
+	NewEntry.HandleCount = Handles.Num();
+	NewEntry.SlotIndex = SlotIndex;
+	HandlePool.Append(Handles.GetData(), Handles.Num());
+
+	const FInputExtensionId NewId{SlotIndex, Slot.Generation};
+	ActorIds.Add(Actor, NewId);
+	return NewId;
+}
+
+void FInputExtensionSlotMap::AppendHandles(const FInputExtensionId Id, TConstArrayView<FInputBindingHandle> Handles)
+{
+	if (Handles.IsEmpty() || Get(Id) == nullptr) { return; }
+
+	FEntry& Entry = Entries[Slots[Id.SlotIndex].Index];
+	if (Entry.HandleStart + Entry.HandleCount != HandlePool.Num())
+	{
+		// not at the tail, move the range there so it stays contiguous
+		const int32 NewStart = HandlePool.Num();
+		HandlePool.Reserve(NewStart + Entry.HandleCount + Handles.Num());
+		for (int32 Index = 0; Index < Entry.HandleCount; ++Index)
+		{
+			const FInputBindingHandle MovedHandle = HandlePool[Entry.HandleStart + Index];
+			HandlePool.Add(MovedHandle);
+		}
+		NumDeadHandles += Entry.HandleCount;
+		Entry.HandleStart = NewStart;
+	}
+
+	HandlePool.Append(Handles.GetData(), Handles.Num());
+	Entry.HandleCount += Handles.Num();
+
+	CompactHandlePool();
+}
+
+void FInputExtensionSlotMap::SetHandles(const FInputExtensionId Id, TConstArrayView<FInputBindingHandle> Handles)
+{
+	if (Get(Id) == nullptr) { return; }
+
+	FEntry& Entry = Entries[Slots[Id.SlotIndex].Index];
+	if (Handles.Num() <= Entry.HandleCount)
+	{
+		for (int32 Index = 0; Index < Handles.Num(); ++Index)
+		{
+			HandlePool[Entry.HandleStart + Index] = Handles[Index];
+		}
+
+		// the unused end of the range is dead, or simply dropped when it is the tail of the pool
+		if (Entry.HandleStart + Entry.HandleCount == HandlePool.Num())
+		{
+			HandlePool.SetNum(Entry.HandleStart + Handles.Num(), EAllowShrinking::No);
+		}
+		else { NumDeadHandles += Entry.HandleCount - Handles.Num(); }
+	}
+	else
+	{
+		ReleaseHandleRange(Entry);
+		Entry.HandleStart = HandlePool.Num();
+		HandlePool.Append(Handles.GetData(), Handles.Num());
+	}
+	Entry.HandleCount = Handles.Num();
+
+	CompactHandlePool();
+}
+
+void FInputExtensionSlotMap::SetMapping(const FInputExtensionId Id, UInputMappingContext* Mapping, const int32 MappingPriority)
+{
+	if (Get(Id) == nullptr) { return; }
+
+	FEntry& Entry = Entries[Slots[Id.SlotIndex].Index];
+	Entry.Mapping = Mapping;
+	Entry.MappingPriority = MappingPriority;
+}
+
+FInputExtensionId FInputExtensionSlotMap::Find(const AActor* Actor) const
+{
+	const FInputExtensionId* const Id = ActorIds.Find(Actor);
+	return Id != nullptr ? *Id : FInputExtensionId();
+}
+
+const FInputExtensionSlotMap::FEntry* FInputExtensionSlotMap::Get(const FInputExtensionId Id) const
+{
+	if (!Slots.IsValidIndex(Id.SlotIndex)) { return nullptr; }
+
+	const FSlot& Slot = Slots[Id.SlotIndex];
+	if (Slot.Generation != Id.Generation || !Entries.IsValidIndex(Slot.Index) || Entries[Slot.Index].SlotIndex != Id.SlotIndex)
+	{
+		return nullptr;
+	}
+
+	return &Entries[Slot.Index];
+}
+
+bool FInputExtensionSlotMap::Remove(const TObjectKey<AActor> Actor, TFunctionRef<void(const FEntry&, TConstArrayView<FInputBindingHandle>)> OnRemoved)
+{
+	// a single hash lookup, everything else is indexed
+	FInputExtensionId Id;
+	if (!ActorIds.RemoveAndCopyValue(Actor, Id)) { return false; }
+
+	const FEntry& Entry = Entries[Slots[Id.SlotIndex].Index];
+	OnRemoved(Entry, GetHandles(Entry));
+
+	RemoveEntry(Id.SlotIndex);
+	return true;
+}
+
+bool FInputExtensionSlotMap::Remove(const TObjectKey<AActor> Actor)
+{
+	return Remove(Actor, [](const FEntry&, TConstArrayView<FInputBindingHandle>) {});
+}
+
+void FInputExtensionSlotMap::Reset()
+{
+	Slots.Reset();
+	FirstFreeSlot = INDEX_NONE;
+	Entries.Reset();
+	ActorIds.Reset();
+	HandlePool.Reset();
+	NumDeadHandles = 0;
+}
+
+void FInputExtensionSlotMap::RemoveEntry(const int32 SlotIndex)
+{
+	FSlot& Slot = Slots[SlotIndex];
+	const int32 EntryIndex = Slot.Index;
+
+	ReleaseHandleRange(Entries[EntryIndex]);
+
+	// swap the last entry into the hole and repoint its slot
+	Entries.RemoveAtSwap(EntryIndex, EAllowShrinking::No);
+	if (Entries.IsValidIndex(EntryIndex))
+	{
+		Slots[Entries[EntryIndex].SlotIndex].Index = EntryIndex;
+	}
+
+	// invalidate outstanding ids and push the slot on the free list
+	++Slot.Generation;
+	Slot.Index = FirstFreeSlot;
+	FirstFreeSlot = SlotIndex;
+
+	CompactHandlePool();
+}
+
+void FInputExtensionSlotMap::ReleaseHandleRange(const FEntry& Entry)
+{
+	if (Entry.HandleStart + Entry.HandleCount == HandlePool.Num())
+	{
+		// tail range, just shrink the pool
+		HandlePool.SetNum(Entry.HandleStart, EAllowShrinking::No);
+	}
+	else { NumDeadHandles += Entry.HandleCount; }
+}
+
+void FInputExtensionSlotMap::CompactHandlePool()
+{
+	// only repack once at least half of the pool is dead, keeps removal amortized O(1)
+	if (NumDeadHandles == 0 || NumDeadHandles * 2 < HandlePool.Num()) { return; }
+
+	TArray<FInputBindingHandle> PackedPool;
+	PackedPool.Reserve(HandlePool.Num() - NumDeadHandles);
+	for (FEntry& Entry : Entries)
+	{
+		const int32 NewStart = PackedPool.Num();
+		PackedPool.Append(HandlePool.GetData() + Entry.HandleStart, Entry.HandleCount);
+		Entry.HandleStart = NewStart;
+	}
+
+	HandlePool = MoveTemp(PackedPool);
+	NumDeadHandles = 0;
+}
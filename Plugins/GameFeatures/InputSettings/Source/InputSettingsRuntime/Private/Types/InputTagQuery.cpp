@@ -0,0 +1,154 @@
+﻿#include "Types/InputTagQuery.h"
+
+#include "GameplayTagAssetInterface.h"
+#include "InputSettingsStats.h"
+#include "Types/InputSettingStructs.h"
+
+bool FInputTagQuery::Compile(const FInputTagRequirements& Requirements)
+{
+	QueryTags.Reset();
+	AllMask = AnyMask = BlockedMask = ExactMask = 0;
+	RequiredActorTagNames = Requirements.RequireAllActorTagNames;
+	bValid = true;
+
+	const auto AddToMask = [this](const FGameplayTagContainer& Tags, uint64& Mask, const bool bExact = false)
+	{
+		for (const FGameplayTag& Tag : Tags)
+		{
+			const int32 Bit = FindOrAddTagBit(Tag, bExact);
+			if (Bit == INDEX_NONE)
+			{
+				// dropping a required or blocked tag would widen the gate, match nothing instead
+				bValid = false;
+				return;
+			}
+			Mask |= uint64(1) << Bit;
+		}
+	};
+
+	AddToMask(Requirements.RequireAllTags, AllMask);
+	AddToMask(Requirements.RequireAnyTags, AnyMask);
+	AddToMask(Requirements.BlockedTags, BlockedMask);
+	AddToMask(Requirements.RequireAllExactTags, AllMask, true);
+
+	if (!bValid)
+	{
+		QueryTags.Reset();
+		AllMask = AnyMask = BlockedMask = ExactMask = 0;
+	}
+
+	return bValid;
+}
+
+uint64 FInputTagQuery::MakeTagBits(const FGameplayTagContainer& Tags) const
+{
+	uint64 TagBits = 0;
+	for (int32 Bit = 0; Bit < QueryTags.Num(); ++Bit)
+	{
+		const bool bExact = (ExactMask & (uint64(1) << Bit)) != 0;
+		if (bExact ? Tags.HasTagExact(QueryTags[Bit]) : Tags.HasTag(QueryTags[Bit]))
+		{
+			TagBits |= uint64(1) << Bit;
+		}
+	}
+
+	return TagBits;
+}
+
+bool FInputTagQuery::MatchesActor(const AActor* TargetActor) const
+{
+	if (!bValid || !IsValid(TargetActor)) { return false; }
+
+	for (const FName& TagName : RequiredActorTagNames)
+	{
+		if (!TargetActor->ActorHasTag(TagName)) { return false; }
+	}
+
+	if (QueryTags.IsEmpty()) { return true; }
+
+	FGameplayTagContainer ActorTags;
+	GetActorTags(TargetActor, ActorTags);
+	return Matches(ActorTags);
+}
+
+void FInputTagQuery::GetActorTags(const AActor* TargetActor, FGameplayTagContainer& OutTags)
+{
+	if (!IsValid(TargetActor)) { return; }
+
+	// names that aren't gameplay tags can only satisfy RequiredActorTagNames, see MatchesActor
+	for (const FName& TagName : TargetActor->Tags)
+	{
+		if (const FGameplayTag Tag = FGameplayTag::RequestGameplayTag(TagName, false); Tag.IsValid())
+		{
+			OutTags.AddTag(Tag);
+		}
+	}
+
+	if (const IGameplayTagAssetInterface* const TagInterface = Cast<IGameplayTagAssetInterface>(TargetActor))
+	{
+		FGameplayTagContainer OwnedTags;
+		TagInterface->GetOwnedGameplayTags(OwnedTags);
+		OutTags.AppendTags(OwnedTags);
+	}
+}
+
+uint32 FInputTagQuery::GetActorTagsHash(const AActor* TargetActor)
+{
+	if (!IsValid(TargetActor)) { return 0; }
+
+	return HashCombineFast(GetActorNameTagsHash(TargetActor), GetOwnedTagsHash(TargetActor));
+}
+
+uint32 FInputTagQuery::GetActorNameTagsHash(const AActor* TargetActor)
+{
+	if (!IsValid(TargetActor)) { return 0; }
+
+	// hash the raw names, they are only converted to gameplay tags when the signature changes
+	uint32 Hash = GetTypeHash(TargetActor->Tags.Num());
+	for (const FName& TagName : TargetActor->Tags)
+	{
+		Hash = HashCombineFast(Hash, GetTypeHash(TagName));
+	}
+
+	return Hash;
+}
+
+uint32 FInputTagQuery::GetOwnedTagsHash(const AActor* TargetActor)
+{
+	const IGameplayTagAssetInterface* const TagInterface = Cast<IGameplayTagAssetInterface>(TargetActor);
+	if (TagInterface == nullptr) { return 0; }
+
+	FGameplayTagContainer OwnedTags;
+	TagInterface->GetOwnedGameplayTags(OwnedTags);
+
+	uint32 Hash = GetTypeHash(OwnedTags.Num());
+	for (const FGameplayTag& Tag : OwnedTags)
+	{
+		Hash = HashCombineFast(Hash, GetTypeHash(Tag));
+	}
+
+	return Hash;
+}
+
+int32 FInputTagQuery::FindOrAddTagBit(const FGameplayTag& Tag, const bool bExact)
+{
+	for (int32 Bit = 0; Bit < QueryTags.Num(); ++Bit)
+	{
+		if (QueryTags[Bit] == Tag && ((ExactMask & (uint64(1) << Bit)) != 0) == bExact) { return Bit; }
+	}
+
+	if (QueryTags.Num() >= MaxTags)
+	{
+		UE_LOG(LogInputSettings, Error, TEXT("%s: More than %d distinct required tags at %s, the requirements match no actor."),
+		       *FString(__FUNCTION__), MaxTags, *Tag.ToString());
+		return INDEX_NONE;
+	}
+
+	const int32 Bit = QueryTags.Add(Tag);
+	if (bExact)
+	{
+		ExactMask |= uint64(1) << Bit;
+	}
+
+	return Bit;
+}
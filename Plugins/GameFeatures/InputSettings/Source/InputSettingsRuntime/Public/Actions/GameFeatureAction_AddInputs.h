@@ -2,45 +2,183 @@
 
 #include "CoreMinimal.h"
 #include "EnhancedInputComponent.h"
+#include "Engine/World.h"
 #include "GameFeatureAction.h"
 #include "GameFeaturesSubsystem.h"
-#include "Components/GameFrameworkComponentManager.h"
+#include "Subsystems/InputMappingContextRegistry.h"
+#include "Types/InputExtensionSlotMap.h"
 #include "Types/InputSettingStructs.h"
+#include "Types/InputTagQuery.h"
 #include "GameFeatureAction_AddInputs.generated.h"
 
 class UInputMappingContext;
 class UEnhancedInputLocalPlayerSubsystem;
-struct FComponentRequestHandle;
+class UInputExtensionDispatcher;
+struct FInputExtensionEvent;
+struct FStreamableHandle;
+class FInputSettingsBenchmark;
 
 UCLASS(BlueprintType, meta=(DisplayName="Add Inputs"))
 class INPUTSETTINGSRUNTIME_API UGameFeatureAction_AddInputs : public UGameFeatureAction
 {
 	GENERATED_BODY()
 
+	// drives a transient copy of the action through activation and possession churn
+	friend class FInputSettingsBenchmark;
+	// forwards the extension events of the shared per pawn class handler
+	friend class UInputExtensionDispatcher;
+
 public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
 	FInputActionSettings InputActionSettings;
 
+	/* Queue extension events per world and process them once per frame instead of on arrival */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings|Batching")
+	bool bBatchExtensionEvents = false;
+
+	/* Max time in milliseconds spent flushing queued extension events per frame, 0 flushes the whole queue */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings|Batching", meta = (EditCondition = "bBatchExtensionEvents", ClampMin = "0"))
+	float BatchTimeBudgetMs = 0.f;
+
+	/* Compile missing binding plans on a worker thread, actors of the class are bound on the game thread once the plan is ready */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings|Batching")
+	bool bPrepareBindingPlansAsync = false;
+
+	/* Number of queued extension events dropped because they duplicated or cancelled another queued event */
+	int32 GetNumCoalescedExtensionEvents() const { return NumCoalescedExtensionEvents; }
+
+	/*
+	 * Replace the settings while the feature is active, only the difference is applied to the extended actors once the new assets are streamed.
+	 * A new TargetPawnClass can't be applied in place, it is kept and takes effect on the next activation, returns false then.
+	 */
+	bool ApplyInputActionSettings(const FInputActionSettings& NewSettings);
+
+	/* Forget the cached tag match of the actor, call it when its IGameplayTagAssetInterface tags change */
+	void InvalidateActorTagCache(const AActor* TargetActor);
+
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PreSave(FObjectPreSaveContext ObjectSaveContext) override;
+	virtual EDataValidationResult IsDataValid(FDataValidationContext& Context) const override;
+#endif
+
 protected:
 	virtual void OnGameFeatureActivating(FGameFeatureActivatingContext& Context) override;
 	virtual void OnGameFeatureDeactivating(FGameFeatureDeactivatingContext& Context) override;
 
 	void AddToWorld(const FWorldContext& WorldContext);
 
-	UGameFrameworkComponentManager* GetGameFrameworkComponentManager(const FWorldContext& WorldContext) const;
-	TArray<TSharedPtr<FComponentRequestHandle>> ActiveRequests;
+	UInputExtensionDispatcher* GetExtensionDispatcher(const FWorldContext& WorldContext) const;
+	// dispatchers this action listens to, one per game instance
+	TArray<TWeakObjectPtr<UInputExtensionDispatcher>> ActiveDispatchers;
 
 	void ResetExtensions();
 
 private:
+	// world independent part of the feature (de)activation
+	void ActivateInputs();
+	void DeactivateInputs();
+
+	// stream the new InputActionSettings, then ApplySettingsDiff
+	void ReapplyInputActionSettings();
+
+	// settings the extended actors are currently bound with
+	FInputActionSettings AppliedActionSettings;
+
+	// hash the bindings once per change of InputActionSettings instead of on every plan lookup
+	void UpdateBindingsHash();
+
+	// recompile CompiledTagQuery from InputActionSettings and drop the cached matches
+	void CompileTagQuery();
+
 	void HandleGameInstanceStart(UGameInstance* GameInstance, FGameFeatureStateChangeContext ChangeContext);
 	FDelegateHandle GameInstanceStartHandle;
 
-	void HandleActorExtension(AActor* Owner, const FName EventName);
-	bool IsActorHasAllRequiredTags(const AActor* TargetActor, const TArray<FName>& RequireTags) const;
+	// game instances without a local player or a world yet, the extension handler is registered once both exist
+	void WaitForLocalPlayerWorld(UGameInstance* GameInstance);
+	void StopWaitingForLocalPlayerWorld(UGameInstance* GameInstance);
+	void TryAddWaitingGameInstance(UGameInstance* GameInstance);
+	void HandleLocalPlayerAdded(ULocalPlayer* LocalPlayer);
+	void HandleWorldInitializedActors(const UWorld::FActorsInitializedParams& Params);
+	TMap<TWeakObjectPtr<UGameInstance>, FDelegateHandle> LocalPlayerAddedHandles;
+	// shared by every waiting game instance, bound while LocalPlayerAddedHandles isn't empty
+	FDelegateHandle WorldInitializedActorsHandle;
+
+	void HandleExtensionEvent(const FInputExtensionEvent& Event);
+	void ApplyActorExtension(AActor* Owner, const bool bAddInputs, const TOptional<uint32>& KnownTagsHash = {});
+	bool DoesActorMatchTagRequirements(const AActor* TargetActor, const TOptional<uint32>& KnownTagsHash = {});
+
+	struct FCachedTagMatch
+	{
+		uint32 TagsHash = 0;
+		bool bMatches = false;
+	};
+
+	FInputTagQuery CompiledTagQuery;
+	// per actor result of CompiledTagQuery, reused until the actor's tag signature changes
+	TMap<TObjectKey<AActor>, FCachedTagMatch> CachedTagMatches;
 
 	void AddActorInputs(AActor* TargetActor);
-	void RemoveActorInputs(AActor* TargetActor);
+	// releases through the subsystem cached with the entry, also for an actor that is gone or changed controller
+	void RemoveActorInputs(const TObjectKey<AActor> TargetActor);
+	void ReleaseExtension(const FInputExtensionSlotMap::FEntry& Entry, TConstArrayView<FInputBindingHandle> Handles);
+
+	FInputExtensionSlotMap ActiveExtensions;
+
+	// stream the whole settings bundle on activation so possession never touches the loader
+	void PreloadInputSettings();
+	void HandleInputSettingsLoaded();
+	bool IsPreloadingInputSettings() const;
+
+	TSharedPtr<FStreamableHandle> InputSettingsLoadHandle;
+
+	// patch the extended actors from AppliedActionSettings to InputActionSettings and extend the ones that newly match
+	void ApplySettingsDiff();
+	// set by ReapplyInputActionSettings until the new bundle is resident and ApplySettingsDiff ran
+	bool bSettingsDiffPending = false;
+	// actors extended while the bundle was still streaming, bound once the handle completes
+	TArray<TWeakObjectPtr<AActor>> PendingLoadActors;
+
+	// true when the actor waits for its binding plan to be compiled off the game thread
+	bool TryDeferToAsyncPlan(AActor* TargetActor);
+	void HandleBindingPlanReady();
+	void BindPendingActors(TArray<TWeakObjectPtr<AActor>>& PendingActors);
+
+	// actors waiting for their plan, bound by HandleBindingPlanReady
+	TArray<TWeakObjectPtr<AActor>> PendingPlanActors;
+
+	struct FPendingExtensionEvent
+	{
+		TWeakObjectPtr<AActor> Actor;
+		// still identifies the entry once the actor is gone
+		TObjectKey<AActor> ActorKey;
+		// unset once cancelled by an opposite event of the same actor
+		TOptional<bool> bAddInputs;
+	};
+
+	struct FPendingExtensionQueue
+	{
+		TArray<FPendingExtensionEvent> Events;
+		// index of the queued event of each actor, one live event per actor at most
+		TMap<TObjectKey<AActor>, int32> ActorEventIndices;
+		int32 NextEventIndex = 0;
+		bool bFlushScheduled = false;
+	};
+
+	void EnqueueActorExtension(AActor* Owner, const bool bAddInputs);
+	void FlushPendingExtensions(TWeakObjectPtr<UWorld> WeakWorld);
+	void ScheduleExtensionFlush(UWorld* World, FPendingExtensionQueue& Queue);
+
+	TMap<TWeakObjectPtr<UWorld>, FPendingExtensionQueue> PendingExtensionQueues;
+	int32 NumCoalescedExtensionEvents = 0;
+
+	// groups the mapping context changes of many actors into one rebuild per player, scopes can nest
+	void BeginMappingBatch();
+	void EndMappingBatch();
+	FInputMappingContextBatch* GetActiveMappingBatch();
 
-	TMap<TWeakObjectPtr<AActor>, FInputBindingData> ActiveExtensions;
+	FInputMappingContextBatch MappingBatch;
+	int32 MappingBatchDepth = 0;
 };
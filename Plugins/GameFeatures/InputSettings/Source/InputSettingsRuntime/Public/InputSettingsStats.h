@@ -0,0 +1,19 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "InputSettingsCoreStats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Stats/Stats.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Add Actor Inputs"), STAT_InputSettings_AddActorInputs, STATGROUP_InputSettings, INPUTSETTINGSRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Setup Input Bindings"), STAT_InputSettings_SetupInputBindings, STATGROUP_InputSettings, INPUTSETTINGSRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Remove Actor Inputs"), STAT_InputSettings_RemoveActorInputs, STATGROUP_InputSettings, INPUTSETTINGSRUNTIME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Synchronous Load"), STAT_InputSettings_SyncLoad, STATGROUP_InputSettings, INPUTSETTINGSRUNTIME_API);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Bindings"), STAT_InputSettings_LiveBindings, STATGROUP_InputSettings, INPUTSETTINGSRUNTIME_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pending Extensions"), STAT_InputSettings_PendingExtensions, STATGROUP_InputSettings, INPUTSETTINGSRUNTIME_API);
+
+// one scope shows up both in "stat InputSettings" and on the InputSettings trace channel in Insights
+#define INPUTSETTINGS_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Stat, InputSettingsChannel)
@@ -0,0 +1,92 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/UObjectGlobals.h"
+#include "Types/InputBindingPlan.h"
+
+struct FInputActionSettings;
+struct FCompiledInputBindingTable;
+
+/*
+ * Caches compiled binding plans keyed by (function owner class, binding content of the settings).
+ * Copies of the same settings share their plans, a plan never outlives the content it was compiled from under another address.
+ * Plans are dropped on hot reload, blueprint reinstancing or when the owning settings are edited.
+ */
+class INPUTSETTINGSRUNTIME_API FInputBindingPlanCache : public FGCObject
+{
+public:
+	static FInputBindingPlanCache& Get();
+	static void TearDown();
+
+	FInputBindingPlanCache();
+	virtual ~FInputBindingPlanCache() override;
+
+	/* Return the cached plan for the owner class, compiling it on first use */
+	TSharedRef<const FInputBindingPlan> FindOrCompile(UClass* OwnerClass, const FInputActionSettings& ActionSettings);
+
+	/* Cached plan or null, never compiles */
+	TSharedPtr<const FInputBindingPlan> Find(UClass* OwnerClass, const FInputActionSettings& ActionSettings) const;
+
+	/*
+	 * Compile the plan on a worker thread and add it to the cache on the game thread, where OnReady is called.
+	 * The worker only finds objects, so every asset of the settings must already be in memory. Returns false otherwise and nothing is queued.
+	 * OnReady is called even when the plan was invalidated in flight, FindOrCompile then compiles it in place.
+	 */
+	bool CompileAsync(UClass* OwnerClass, const FInputActionSettings& ActionSettings, FSimpleDelegate OnReady);
+
+	/* Drop every plan compiled from this content, call it whenever the settings are edited or released */
+	void Invalidate(const FInputActionSettings& ActionSettings);
+
+	/* Hash of everything a plan is compiled from, equal for copies of the same settings */
+	static uint64 ComputeBindingsHash(const FInputActionSettings& ActionSettings);
+
+	/* The hash stored with the settings, only computed for settings nobody stored it in */
+	static uint64 GetBindingsHash(const FInputActionSettings& ActionSettings);
+	void InvalidateAll();
+
+	//~FGCObject
+	virtual void AddReferencedObjects(FReferenceCollector& Collector) override;
+	virtual FString GetReferencerName() const override;
+	//~End of FGCObject
+
+private:
+	// without bAllowLoad the assets are only looked up, which is safe off the game thread while GC is held off
+	static void CompilePlan(FInputBindingPlan& Plan, const FInputActionSettings& ActionSettings, const bool bAllowLoad);
+	static void CompilePlanFromTable(FInputBindingPlan& Plan, const FCompiledInputBindingTable& Table, const bool bAllowLoad);
+
+	void HandleReloadComplete(EReloadCompleteReason Reason);
+#if WITH_EDITOR
+	void HandleObjectsReplaced(const TMap<UObject*, UObject*>& ReplacementMap);
+#endif
+
+	struct FPlanKey
+	{
+		TObjectKey<UClass> OwnerClass;
+		uint64 BindingsHash = 0;
+
+		bool operator==(const FPlanKey& Other) const { return OwnerClass == Other.OwnerClass && BindingsHash == Other.BindingsHash; }
+		friend uint32 GetTypeHash(const FPlanKey& Key) { return HashCombine(GetTypeHash(Key.OwnerClass), GetTypeHash(Key.BindingsHash)); }
+	};
+
+	// game thread side of CompileAsync, a no-op once the cache was torn down
+	static void CommitAsyncPlan(const FPlanKey Key, const uint32 CompiledGeneration);
+
+	TMap<FPlanKey, TSharedRef<FInputBindingPlan>> Plans;
+
+	struct FPendingPlan
+	{
+		// filled by the worker under a GC guard, reported to GC like the cached plans
+		TSharedRef<FInputBindingPlan> Plan;
+		TArray<FSimpleDelegate, TInlineAllocator<2>> OnReady;
+	};
+
+	TMap<FPlanKey, FPendingPlan> PendingPlans;
+	// bumped by every invalidation, a plan compiled against an older generation is dropped on commit
+	uint32 Generation = 0;
+
+	FDelegateHandle ReloadCompleteHandle;
+	FDelegateHandle BindersChangedHandle;
+	FDelegateHandle ObjectsReplacedHandle;
+};
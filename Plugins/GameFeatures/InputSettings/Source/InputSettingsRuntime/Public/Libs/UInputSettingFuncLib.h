@@ -6,8 +6,15 @@
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "InputMappingContext.h"
+#include "Engine/StreamableManager.h"
+#include "InputSettingsStats.h"
+#include "Subsystems/InputMappingContextRegistry.h"
 #include "UInputSettingFuncLib.generated.h"
 
+struct FInputBindingPlan;
+
+DECLARE_DELEGATE_OneParam(FOnActorInputsAdded, const TArray<FInputBindingHandle>& /*BindingHandles*/);
+
 UCLASS()
 class INPUTSETTINGSRUNTIME_API UInputSettingFuncLib : public UBlueprintFunctionLibrary
 {
@@ -18,15 +25,64 @@ public:
 
 	static UEnhancedInputComponent* GetInputComponentFromActor(AActor* TargetActor);
 
+	/* Both lookups above are cached per pawn and revalidated against its controller, drop the entry on possession changes */
+	static void InvalidateResolvedInput(const APawn* TargetPawn);
+
 	static UObject* GetInputOwnerObject(UObject* InObject, const EInputBindingOwnerOverride& InOwner);
 
-	static TArray<FInputBindingHandle> AddActorInputs(AActor* TargetActor, const FInputActionSettings& ActionSettings);
+	static TArray<FInputBindingHandle> AddActorInputs(AActor* TargetActor, const FInputActionSettings& ActionSettings,
+	                                                  FInputMappingContextBatch* MappingBatch = nullptr);
 	
-	static TArray<FInputBindingHandle> AddActorInputs(AActor* TargetActor,UObject* BoundFuncSource, const FInputActionSettings& ActionSettings);
+	static TArray<FInputBindingHandle> AddActorInputs(AActor* TargetActor,UObject* BoundFuncSource, const FInputActionSettings& ActionSettings,
+	                                                  FInputMappingContextBatch* MappingBatch = nullptr);
+
+	/* MappingPriority must be the priority the context was added with, references are counted per priority */
+	static bool RemoveActorInputs(AActor* TargetActor, TConstArrayView<FInputBindingHandle> BindingHandles,
+	                              const UInputMappingContext* MappingContext, const int32 MappingPriority,
+	                              FInputMappingContextBatch* MappingBatch = nullptr);
+
+	/* RemoveActorInputs through the subsystem and input component the actor was bound with, for actors that are already gone */
+	static void RemoveResolvedInputs(UEnhancedInputLocalPlayerSubsystem* Subsystem, UEnhancedInputComponent* InputComponent,
+	                                 TConstArrayView<FInputBindingHandle> BindingHandles, const UInputMappingContext* MappingContext,
+	                                 const int32 MappingPriority, FInputMappingContextBatch* MappingBatch = nullptr);
+
+	/*
+	 * Move an actor bound with OldSettings over to NewSettings, touching only what differs.
+	 * Bindings present in both plans keep their handle, the mapping context is only swapped when it or its priority changed.
+	 * BindingHandles must be in the order AddActorInputs returned them, OutHandles is in the order of the NewSettings plan.
+	 * Returns false when the actor can't be reached anymore (no local player or input component), nothing is touched then.
+	 */
+	static bool UpdateActorInputs(AActor* TargetActor, TConstArrayView<FInputBindingHandle> BindingHandles,
+	                              const FInputActionSettings& OldSettings, const FInputActionSettings& NewSettings,
+	                              TArray<FInputBindingHandle>& OutHandles, FInputMappingContextBatch* MappingBatch = nullptr);
 
-	static bool RemoveActorInputs(AActor* TargetActor, const TArray<FInputBindingHandle>& BindingHandles,
-	                              const UInputMappingContext* MappingContext);
+	/* Collect every soft reference (mapping context and input actions) held by the settings */
+	static void GetInputSettingsAssetPaths(const FInputActionSettings& ActionSettings, TArray<FSoftObjectPath>& OutPaths);
+
+	/* True when the mapping context and every input action of the settings are already in memory */
+	static bool IsInputSettingsLoaded(const FInputActionSettings& ActionSettings);
+
+	/* Stream in the whole settings bundle through the asset manager, returns null when there is nothing to load */
+	static TSharedPtr<FStreamableHandle> RequestAsyncLoadInputSettings(const FInputActionSettings& ActionSettings,
+	                                                                   FStreamableDelegate OnLoaded = FStreamableDelegate());
+
+	/* Same as AddActorInputs, but the bindings are applied once the settings bundle has been streamed in */
+	static TSharedPtr<FStreamableHandle> AddActorInputsAsync(AActor* TargetActor, const FInputActionSettings& ActionSettings,
+	                                                         FOnActorInputsAdded OnInputsAdded);
+
+	/* Prefer the already streamed object, only block on the loader when nothing preloaded it */
+	template <typename T>
+	static T* ResolveSoftObject(const TSoftObjectPtr<T>& SoftObject)
+	{
+		if (T* const LoadedObject = SoftObject.Get()) { return LoadedObject; }
+
+		INPUTSETTINGS_SCOPE_CYCLE_COUNTER(STAT_InputSettings_SyncLoad);
+		return SoftObject.LoadSynchronous();
+	}
 
 private:
 	static TArray<FInputBindingHandle> SetupInputBindings(AActor* InActor, UObject* FunctionOwner, const FInputActionSettings& ActionSettings);
+
+	static FInputBindingHandle BindPlannedAction(UEnhancedInputComponent& InputComponent, const FInputBindingPlan& Plan, const int32 Index,
+	                                             UObject* FunctionOwner);
 };
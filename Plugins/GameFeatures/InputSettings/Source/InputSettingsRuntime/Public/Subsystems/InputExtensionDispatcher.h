@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "InputExtensionDispatcher.generated.h"
+
+class AController;
+class APawn;
+class UEnhancedInputLocalPlayerSubsystem;
+class UGameFeatureAction_AddInputs;
+struct FComponentRequestHandle;
+
+/* One extension event of a pawn, classified and resolved once and shared by every action listening to its class */
+struct FInputExtensionEvent
+{
+	AActor* Actor = nullptr;
+	bool bAddInputs = false;
+
+	// subsystem of the pawn's local player, null when the pawn isn't locally controlled
+	UEnhancedInputLocalPlayerSubsystem* Subsystem = nullptr;
+
+	// UInputExtensionDispatcher::GetActorTagsHash of the actor, only set for add events
+	TOptional<uint32> TagsHash;
+};
+
+/*
+ * Registers a single extension handler per pawn class with the component manager and fans its events out to
+ * every AddInputs action targeting that class, instead of one handler and one callback per pawn for each action.
+ */
+UCLASS()
+class INPUTSETTINGSRUNTIME_API UInputExtensionDispatcher : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/* Forward the extension events of PawnClass to the action, pawns the class handler already extended are replayed to it */
+	bool AddListener(UGameFeatureAction_AddInputs* Action, const TSoftClassPtr<APawn>& PawnClass);
+
+	/* Stop forwarding events to the action, a class handler is released along with its last listener */
+	void RemoveListener(const UGameFeatureAction_AddInputs* Action);
+
+	/* Pawns currently extended through the handlers the action listens to, whether the action bound them or not */
+	void GetExtendedActors(const UGameFeatureAction_AddInputs* Action, TArray<AActor*>& OutActors) const;
+
+	/* Extension handlers currently registered with the component manager, one per listened pawn class */
+	int32 GetNumExtensionHandlers() const { return ClassListeners.Num(); }
+
+	/*
+	 * FInputTagQuery::GetActorTagsHash with the IGameplayTagAssetInterface half cached per actor until InvalidateActorTags.
+	 * Actor FName tags are hashed on every call, they are a plain array without a change notification.
+	 */
+	uint32 GetActorTagsHash(const AActor* Actor);
+
+	/* Drop the cached owned tags of the actor, call it whenever its IGameplayTagAssetInterface tags change */
+	void InvalidateActorTags(const AActor* Actor);
+
+private:
+	void HandleActorExtension(AActor* Owner, const FName EventName, TSoftClassPtr<APawn> PawnClass);
+
+	// FInputTagQuery::GetOwnedTagsHash per actor implementing IGameplayTagAssetInterface
+	TMap<TObjectKey<AActor>, uint32> CachedOwnedTagsHashes;
+
+	/* Drops the cached input lookups of the pawn's previous controller */
+	UFUNCTION()
+	void HandlePawnControllerChanged(APawn* Pawn, AController* Controller);
+
+	struct FClassListeners
+	{
+		TSharedPtr<FComponentRequestHandle> Request;
+		TArray<TWeakObjectPtr<UGameFeatureAction_AddInputs>, TInlineAllocator<4>> Actions;
+		// pawns currently extended through the handler, replayed to actions listening later
+		TSet<TWeakObjectPtr<AActor>> ExtendedActors;
+	};
+
+	TMap<TSoftClassPtr<APawn>, FClassListeners> ClassListeners;
+};
@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/SoftObjectPath.h"
+#include "CompiledInputBindingTable.generated.h"
+
+struct FInputActionSettings;
+
+/* One function bound to one action, every trigger of the binding is packed in a mask of ETriggerEvent flags */
+USTRUCT()
+struct FCompiledInputBinding
+{
+	GENERATED_BODY()
+
+	/* Index into FCompiledInputBindingTable::Actions */
+	UPROPERTY()
+	int32 ActionIndex = INDEX_NONE;
+
+	UPROPERTY()
+	FName FunctionName;
+
+	UPROPERTY()
+	uint8 TriggerMask = 0;
+
+	UPROPERTY()
+	bool bPreferNativeBinding = true;
+};
+
+/*
+ * Flattened and validated form of FInputActionSettings::ActionsBindings, built when the owning action is cooked.
+ * Binding plans are compiled straight from it, without walking and checking the authored nested arrays.
+ */
+USTRUCT()
+struct INPUTSETTINGSRUNTIME_API FCompiledInputBindingTable
+{
+	GENERATED_BODY()
+
+	/* Unique input actions referenced by the bindings */
+	UPROPERTY()
+	TArray<FSoftObjectPath> Actions;
+
+	UPROPERTY()
+	TArray<FCompiledInputBinding> Bindings;
+
+	UPROPERTY()
+	bool bCompiled = false;
+
+	bool IsCompiled() const { return bCompiled; }
+	void Reset() { *this = FCompiledInputBindingTable(); }
+
+#if WITH_EDITOR
+	/*
+	 * Flatten the settings and validate them, every problem is appended to OutErrors.
+	 * Function names are only verified when OwnerClass is given, returns true and marks the table compiled when nothing was wrong.
+	 */
+	bool Build(const FInputActionSettings& ActionSettings, const UClass* OwnerClass, TArray<FText>& OutErrors);
+#endif
+};
@@ -0,0 +1,43 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "EnhancedInputComponent.h"
+#include "Libs/InputNativeBindingRegistry.h"
+
+class UInputAction;
+
+/*
+ * Flattened, pre-resolved bindings of one FInputActionSettings for one function owner class.
+ * Entries are stored as parallel arrays, index N of each array describes the Nth binding.
+ */
+struct INPUTSETTINGSRUNTIME_API FInputBindingPlan
+{
+	/* Class the functions were resolved against */
+	TObjectPtr<UClass> OwnerClass;
+
+	TArray<TObjectPtr<UInputAction>> Actions;
+	// null when the binding only has a native binder
+	TArray<UFunction*> Functions;
+	TArray<ETriggerEvent> Triggers;
+	// set when a native binder was registered for the function, bound instead of the reflected function
+	TArray<TSharedPtr<const FInputNativeBinder>> NativeBinders;
+
+	int32 Num() const { return Triggers.Num(); }
+	bool IsEmpty() const { return Triggers.IsEmpty(); }
+
+	/* True when binding Index of this plan and binding OtherIndex of Other call the same function for the same action and trigger */
+	bool IsSameBinding(const int32 Index, const FInputBindingPlan& Other, const int32 OtherIndex) const
+	{
+		return Triggers[Index] == Other.Triggers[OtherIndex] && Actions[Index] == Other.Actions[OtherIndex]
+			&& Functions[Index] == Other.Functions[OtherIndex] && NativeBinders[Index] == Other.NativeBinders[OtherIndex];
+	}
+
+	void Add(UInputAction* InAction, UFunction* InFunction, const ETriggerEvent InTrigger,
+	         const TSharedPtr<const FInputNativeBinder>& InNativeBinder = nullptr)
+	{
+		Actions.Add(InAction);
+		Functions.Add(InFunction);
+		Triggers.Add(InTrigger);
+		NativeBinders.Add(InNativeBinder);
+	}
+};
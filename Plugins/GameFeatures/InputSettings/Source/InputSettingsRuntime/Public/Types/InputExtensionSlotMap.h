@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "EnhancedInputComponent.h"
+#include "UObject/ObjectKey.h"
+
+class UEnhancedInputLocalPlayerSubsystem;
+class UInputMappingContext;
+
+/* Generation checked reference to an entry of FInputExtensionSlotMap, stale once the entry is removed */
+struct FInputExtensionId
+{
+	int32 SlotIndex = INDEX_NONE;
+	uint32 Generation = 0;
+
+	bool IsValid() const { return SlotIndex != INDEX_NONE; }
+};
+
+/*
+ * Dense storage of the actors extended by an input feature.
+ * Entries are packed and swap-removed, every binding handle lives in one shared pool addressed by per-entry ranges.
+ */
+class INPUTSETTINGSRUNTIME_API FInputExtensionSlotMap
+{
+public:
+	struct FEntry
+	{
+		TWeakObjectPtr<AActor> Actor;
+		// still finds the entry after the actor was collected
+		TObjectKey<AActor> ActorKey;
+		// what the actor was bound through, releases the entry once the actor itself is gone
+		TWeakObjectPtr<UEnhancedInputLocalPlayerSubsystem> Subsystem;
+		TWeakObjectPtr<UEnhancedInputComponent> InputComponent;
+		TWeakObjectPtr<UInputMappingContext> Mapping;
+		// the mapping's references are counted per priority, it is released with the one it was added with
+		int32 MappingPriority = 0;
+		int32 HandleStart = 0;
+		int32 HandleCount = 0;
+		int32 SlotIndex = INDEX_NONE;
+	};
+
+	/* Add the actor or append the handles to its existing entry */
+	FInputExtensionId Add(AActor* Actor, UEnhancedInputLocalPlayerSubsystem* Subsystem, UEnhancedInputComponent* InputComponent,
+	                      UInputMappingContext* Mapping, const int32 MappingPriority, TConstArrayView<FInputBindingHandle> Handles);
+
+	/* Append handles to an entry, the range is moved to the end of the pool when it can't grow in place */
+	void AppendHandles(const FInputExtensionId Id, TConstArrayView<FInputBindingHandle> Handles);
+
+	/* Replace the handles of an entry, shrinks in place when possible and moves to the end of the pool otherwise */
+	void SetHandles(const FInputExtensionId Id, TConstArrayView<FInputBindingHandle> Handles);
+	void SetMapping(const FInputExtensionId Id, UInputMappingContext* Mapping, const int32 MappingPriority);
+
+	FInputExtensionId Find(const AActor* Actor) const;
+	bool Contains(const AActor* Actor) const { return ActorIds.Contains(Actor); }
+
+	const FEntry* Get(const FInputExtensionId Id) const;
+	TConstArrayView<FInputBindingHandle> GetHandles(const FEntry& Entry) const { return MakeArrayView(HandlePool.GetData() + Entry.HandleStart, Entry.HandleCount); }
+
+	/* Remove the actor's entry, OnRemoved is called with the entry and its handles right before they are released */
+	bool Remove(const TObjectKey<AActor> Actor, TFunctionRef<void(const FEntry&, TConstArrayView<FInputBindingHandle>)> OnRemoved);
+	bool Remove(const TObjectKey<AActor> Actor);
+
+	void Reset();
+
+	/* Packed entries, suitable for linear walks */
+	TConstArrayView<FEntry> GetEntries() const { return Entries; }
+	int32 Num() const { return Entries.Num(); }
+	int32 NumHandles() const { return HandlePool.Num() - NumDeadHandles; }
+
+private:
+	struct FSlot
+	{
+		uint32 Generation = 0;
+		// entry index while used, next free slot while free
+		int32 Index = INDEX_NONE;
+	};
+
+	void RemoveEntry(const int32 SlotIndex);
+	void ReleaseHandleRange(const FEntry& Entry);
+	void CompactHandlePool();
+
+	TArray<FSlot> Slots;
+	int32 FirstFreeSlot = INDEX_NONE;
+
+	TArray<FEntry> Entries;
+	TMap<TObjectKey<AActor>, FInputExtensionId> ActorIds;
+
+	TArray<FInputBindingHandle> HandlePool;
+	int32 NumDeadHandles = 0;
+};
@@ -2,8 +2,12 @@
 
 #include "InputMappingContext.h"
 #include "EnhancedInputComponent.h"
+#include "GameplayTagContainer.h"
+#include "Types/CompiledInputBindingTable.h"
 #include "InputSettingStructs.generated.h"
 
+class UEnhancedInputLocalPlayerSubsystem;
+
 UENUM(BlueprintType, Category="Extra Actions | Enums")
 enum class EInputBindingOwnerOverride :uint8
 {
@@ -24,6 +28,10 @@ struct FFunctionStackedData
 	/* Input Trigger event type */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
 	TArray<ETriggerEvent> Triggers;
+
+	/* Bind the native handler registered under FunctionName when there is one, instead of dispatching through the UFunction */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings", AdvancedDisplay)
+	bool bPreferNativeBinding = true;
 };
 
 USTRUCT(BlueprintType, Category = "Extra Actions | Modular Structs")
@@ -40,6 +48,44 @@ struct FInputMappingStack
 	TArray<FFunctionStackedData> FunctionBindingData;
 };
 
+USTRUCT(BlueprintType, Category = "Extra Actions | Modular Structs")
+struct FInputTagRequirements
+{
+	GENERATED_BODY()
+
+	/* Every one of these tags must be present on the target */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
+	FGameplayTagContainer RequireAllTags;
+
+	/* At least one of these tags must be present on the target, ignored when empty */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
+	FGameplayTagContainer RequireAnyTags;
+
+	/* None of these tags may be present on the target */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
+	FGameplayTagContainer BlockedTags;
+
+	/* Legacy required names migrated from RequireTags, every one must be present on the target as is, its children don't count */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings", AdvancedDisplay)
+	FGameplayTagContainer RequireAllExactTags;
+
+	/* Legacy required names that aren't registered gameplay tags, every one must be in the target's actor tags */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Settings", AdvancedDisplay)
+	TArray<FName> RequireAllActorTagNames;
+
+	bool IsEmpty() const
+	{
+		return RequireAllTags.IsEmpty() && RequireAnyTags.IsEmpty() && BlockedTags.IsEmpty() && RequireAllExactTags.IsEmpty()
+			&& RequireAllActorTagNames.IsEmpty();
+	}
+
+	bool operator==(const FInputTagRequirements& Other) const
+	{
+		return RequireAllTags == Other.RequireAllTags && RequireAnyTags == Other.RequireAnyTags && BlockedTags == Other.BlockedTags
+			&& RequireAllExactTags == Other.RequireAllExactTags && RequireAllActorTagNames == Other.RequireAllActorTagNames;
+	}
+};
+
 USTRUCT(BlueprintType, Category = "Extra Actions | Modular Structs")
 struct FInputActionSettings
 {
@@ -53,9 +99,13 @@ struct FInputActionSettings
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
 	EInputBindingOwnerOverride InputBindingOwner = EInputBindingOwnerOverride::Default;
 
-	/* Tags required on the target to apply this action */
-	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
-	TArray<FName> RequireTags;
+	/* Tags required on the target to apply this action, matched against actor tags and owned gameplay tags */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings", meta = (DisplayName = "Require Tags"))
+	FInputTagRequirements TagRequirements;
+
+	/* Legacy FName requirements, migrated into TagRequirements.RequireAllExactTags (or RequireAllActorTagNames when unregistered) on load */
+	UPROPERTY(meta = (DeprecatedProperty, DeprecationMessage = "Use TagRequirements instead."))
+	TArray<FName> RequireTags_DEPRECATED;
 
 	/* Enhanced Input Mapping Context to be added */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
@@ -68,10 +118,11 @@ struct FInputActionSettings
 	/* Enhanced Input Actions binding stacked data */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings", meta = (DisplayName = "Actions Bindings", ShowOnlyInnerProperties))
 	TArray<FInputMappingStack> ActionsBindings;
-};
 
-struct FInputBindingData
-{
-	TArray<FInputBindingHandle> ActionBindingHandle;
-	TWeakObjectPtr<UInputMappingContext> Mapping;
+	/* ActionsBindings flattened and validated at cook time, empty in editor data and after any runtime change */
+	UPROPERTY()
+	FCompiledInputBindingTable CompiledBindings;
+
+	/* FInputBindingPlanCache::ComputeBindingsHash of the content above, set by the owner whenever it changes, 0 when unknown */
+	uint64 BindingsHash = 0;
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+struct FInputTagRequirements;
+
+/*
+ * FInputTagRequirements compiled into bit masks.
+ * Every distinct requirement tag gets a bit, a target's tags are reduced to those bits once and matched with mask tests.
+ */
+struct INPUTSETTINGSRUNTIME_API FInputTagQuery
+{
+	static constexpr int32 MaxTags = 64;
+
+	/* False when the requirements have more than MaxTags distinct tags, the query then matches nothing rather than a looser subset */
+	bool Compile(const FInputTagRequirements& Requirements);
+
+	bool IsValidQuery() const { return bValid; }
+
+	bool IsEmpty() const { return bValid && QueryTags.IsEmpty() && RequiredActorTagNames.IsEmpty(); }
+
+	/* Bit N is set when the container has the Nth requirement tag, or one of its children unless the bit is an exact one */
+	uint64 MakeTagBits(const FGameplayTagContainer& Tags) const;
+
+	bool Matches(const uint64 TagBits) const
+	{
+		return bValid && (TagBits & AllMask) == AllMask && (AnyMask == 0 || (TagBits & AnyMask) != 0) && (TagBits & BlockedMask) == 0;
+	}
+
+	bool Matches(const FGameplayTagContainer& Tags) const { return Matches(MakeTagBits(Tags)); }
+
+	/* Gathers the actor's tags and also checks the required names that aren't gameplay tags */
+	bool MatchesActor(const AActor* TargetActor) const;
+
+	/* Actor FName tags and, when implemented, IGameplayTagAssetInterface owned tags */
+	static void GetActorTags(const AActor* TargetActor, FGameplayTagContainer& OutTags);
+
+	/* Cheap signature of the actor's tags, changes whenever the tags returned by GetActorTags may have changed */
+	static uint32 GetActorTagsHash(const AActor* TargetActor);
+
+	/* The two halves of GetActorTagsHash, the owned tags half is the one worth caching */
+	static uint32 GetActorNameTagsHash(const AActor* TargetActor);
+	static uint32 GetOwnedTagsHash(const AActor* TargetActor);
+
+private:
+	int32 FindOrAddTagBit(const FGameplayTag& Tag, const bool bExact);
+
+	TArray<FGameplayTag, TInlineAllocator<8>> QueryTags;
+	uint64 AllMask = 0;
+	uint64 AnyMask = 0;
+	uint64 BlockedMask = 0;
+	// bits matched with HasTagExact, a tag required both ways gets one bit of each kind
+	uint64 ExactMask = 0;
+	TArray<FName> RequiredActorTagNames;
+	bool bValid = true;
+};
@@ -0,0 +1,134 @@
+﻿#include "Libs/DialogueLineStore.h"
+
+#include "STQS_Structs.h"
+#include "STQuestSystemRuntimeModule.h"
+#include "Engine/DataTable.h"
+#include "Engine/Texture2D.h"
+#include "Sound/SoundBase.h"
+
+namespace DialogueLineStore
+{
+	struct FCachedStore
+	{
+		TWeakObjectPtr<const UDataTable> Table;
+		TSharedRef<const FDialogueLineStore> Store;
+		FDelegateHandle ChangedHandle;
+	};
+
+	TMap<TObjectKey<UDataTable>, FCachedStore> CachedStores;
+}
+
+TSharedRef<const FDialogueLineStore> FDialogueLineStore::Get(const UDataTable* DialogueTable)
+{
+	check(IsInGameThread());
+
+	static const TSharedRef<const FDialogueLineStore> EmptyStore = MakeShared<FDialogueLineStore>();
+	if (!IsValid(DialogueTable)) { return EmptyStore; }
+
+	const TObjectKey<UDataTable> TableKey(DialogueTable);
+	if (const DialogueLineStore::FCachedStore* const CachedStore = DialogueLineStore::CachedStores.Find(TableKey))
+	{
+		// the key of a destroyed table can be reused by a new one
+		if (CachedStore->Table.Get() == DialogueTable) { return CachedStore->Store; }
+
+		DialogueLineStore::CachedStores.Remove(TableKey);
+	}
+
+	const TSharedRef<FDialogueLineStore> Store = MakeShared<FDialogueLineStore>();
+	Store->Compile(*DialogueTable);
+
+	// the table is read only at runtime, this only fires for editor edits and reimports
+	UDataTable* const MutableTable = const_cast<UDataTable*>(DialogueTable);
+	const FDelegateHandle ChangedHandle = MutableTable->OnDataTableChanged().AddStatic(&FDialogueLineStore::HandleDataTableChanged, TableKey);
+
+	DialogueLineStore::CachedStores.Add(TableKey, {DialogueTable, Store, ChangedHandle});
+	return Store;
+}
+
+void FDialogueLineStore::TearDown()
+{
+	for (const TPair<TObjectKey<UDataTable>, DialogueLineStore::FCachedStore>& Pair : DialogueLineStore::CachedStores)
+	{
+		if (UDataTable* const Table = const_cast<UDataTable*>(Pair.Value.Table.Get()))
+		{
+			Table->OnDataTableChanged().Remove(Pair.Value.ChangedHandle);
+		}
+	}
+	DialogueLineStore::CachedStores.Reset();
+}
+
+int32 FDialogueLineStore::FindLineId(const FName RowName) const
+{
+	const int32* const LineId = LineIds.Find(RowName);
+	return LineId != nullptr ? *LineId : INDEX_NONE;
+}
+
+const FText& FDialogueLineStore::GetTargetName(const int32 LineId) const
+{
+	const FDialogueSpeakerRegistry& SpeakerRegistry = FDialogueSpeakerRegistry::Get();
+	const FDialogueSpeakerRegistry::FSpeakerId SpeakerId = GetSpeakerId(LineId);
+	return SpeakerRegistry.IsValidSpeaker(SpeakerId) ? SpeakerRegistry.GetSpeaker(SpeakerId).Name : FText::GetEmpty();
+}
+
+const TSoftObjectPtr<UTexture2D>& FDialogueLineStore::GetFaceImage(const int32 LineId) const
+{
+	static const TSoftObjectPtr<UTexture2D> NoFaceImage;
+
+	const FDialogueSpeakerRegistry& SpeakerRegistry = FDialogueSpeakerRegistry::Get();
+	const FDialogueSpeakerRegistry::FLineSpeaker& LineSpeaker = LineSpeakers[LineId];
+	if (!SpeakerRegistry.IsValidSpeaker(LineSpeaker.SpeakerId)) { return NoFaceImage; }
+
+	const TArray<TSoftObjectPtr<UTexture2D>>& Portraits = SpeakerRegistry.GetSpeaker(LineSpeaker.SpeakerId).Portraits;
+	return Portraits.IsValidIndex(LineSpeaker.PortraitIndex) ? Portraits[LineSpeaker.PortraitIndex] : NoFaceImage;
+}
+
+const TSoftObjectPtr<USoundBase>& FDialogueLineStore::GetVoice(const int32 LineId) const
+{
+	static const TSoftObjectPtr<USoundBase> NoVoice;
+
+	const FDialogueSpeakerRegistry& SpeakerRegistry = FDialogueSpeakerRegistry::Get();
+	const FDialogueSpeakerRegistry::FSpeakerId SpeakerId = GetSpeakerId(LineId);
+	return SpeakerRegistry.IsValidSpeaker(SpeakerId) ? SpeakerRegistry.GetSpeaker(SpeakerId).Voice : NoVoice;
+}
+
+void FDialogueLineStore::Compile(const UDataTable& DialogueTable)
+{
+	if (DialogueTable.GetRowStruct() == nullptr || !DialogueTable.GetRowStruct()->IsChildOf(FDialogueData::StaticStruct()))
+	{
+		UE_LOG(LogSTQuestSystem, Error, TEXT("%s: %s doesn't hold FDialogueData rows."), *FString(__FUNCTION__), *DialogueTable.GetName());
+		return;
+	}
+
+	const TMap<FName, uint8*>& RowMap = DialogueTable.GetRowMap();
+	RowNames.Reserve(RowMap.Num());
+	LineIds.Reserve(RowMap.Num());
+	ContentTexts.Reserve(RowMap.Num());
+	LineSpeakers.Reserve(RowMap.Num());
+	InteractSounds.Reserve(RowMap.Num());
+
+	FDialogueSpeakerRegistry& SpeakerRegistry = FDialogueSpeakerRegistry::Get();
+
+	// ids follow the row order of the table, consecutive lines of a conversation stay adjacent
+	for (const TPair<FName, uint8*>& Row : RowMap)
+	{
+		const FDialogueData& Line = *reinterpret_cast<const FDialogueData*>(Row.Value);
+
+		LineIds.Add(Row.Key, RowNames.Add(Row.Key));
+		ContentTexts.Add(FText::FromString(Line.ContentText));
+		LineSpeakers.Add(SpeakerRegistry.InternLineSpeaker(Line));
+		InteractSounds.Add(Line.InteractSound);
+	}
+}
+
+void FDialogueLineStore::HandleDataTableChanged(TObjectKey<UDataTable> TableKey)
+{
+	// holders of the old store keep it alive, the next Get compiles the edited rows
+	if (DialogueLineStore::FCachedStore* const CachedStore = DialogueLineStore::CachedStores.Find(TableKey))
+	{
+		if (UDataTable* const Table = const_cast<UDataTable*>(CachedStore->Table.Get()))
+		{
+			Table->OnDataTableChanged().Remove(CachedStore->ChangedHandle);
+		}
+		DialogueLineStore::CachedStores.Remove(TableKey);
+	}
+}
@@ -0,0 +1,96 @@
+﻿#include "Libs/DialogueSpeakerRegistry.h"
+
+#include "STQS_Structs.h"
+#include "STQuestSystemRuntimeModule.h"
+#include "Engine/Texture2D.h"
+#include "Sound/SoundBase.h"
+
+namespace DialogueSpeakerRegistry
+{
+	FDialogueSpeakerRegistry* Instance = nullptr;
+}
+
+FDialogueSpeakerRegistry& FDialogueSpeakerRegistry::Get()
+{
+	check(IsInGameThread());
+
+	if (DialogueSpeakerRegistry::Instance == nullptr)
+	{
+		DialogueSpeakerRegistry::Instance = new FDialogueSpeakerRegistry();
+	}
+
+	return *DialogueSpeakerRegistry::Instance;
+}
+
+void FDialogueSpeakerRegistry::TearDown()
+{
+	delete DialogueSpeakerRegistry::Instance;
+	DialogueSpeakerRegistry::Instance = nullptr;
+}
+
+FDialogueSpeakerRegistry::FLineSpeaker FDialogueSpeakerRegistry::InternLineSpeaker(const FDialogueData& Line)
+{
+	const FDialogueSpeakerData* const SpeakerData = Line.Speaker.IsNull() ? nullptr : Line.Speaker.GetRow<FDialogueSpeakerData>(TEXT("FDialogueSpeakerRegistry"));
+
+	FLineSpeaker LineSpeaker;
+	if (SpeakerData == nullptr)
+	{
+		LineSpeaker.SpeakerId = Intern(FSoftObjectPath(), NAME_None, Line.TargetName, nullptr, 1.f);
+		LineSpeaker.PortraitIndex = InternPortrait(LineSpeaker.SpeakerId, Line.FaceImage);
+		return LineSpeaker;
+	}
+
+	LineSpeaker.SpeakerId = Intern(FSoftObjectPath(Line.Speaker.DataTable), Line.Speaker.RowName, SpeakerData->Name, SpeakerData->Voice,
+	                               SpeakerData->VoicePitch);
+
+	const TSoftObjectPtr<UTexture2D>* const Portrait = Line.Portrait.IsNone() ? nullptr : SpeakerData->Portraits.Find(Line.Portrait);
+	LineSpeaker.PortraitIndex = InternPortrait(LineSpeaker.SpeakerId, Portrait != nullptr ? *Portrait : SpeakerData->DefaultPortrait);
+	return LineSpeaker;
+}
+
+FDialogueSpeakerRegistry::FSpeakerId FDialogueSpeakerRegistry::Intern(const FSoftObjectPath& SpeakerTable, const FName SpeakerRow, const FString& Name,
+                                                                    const TSoftObjectPtr<USoundBase>& Voice, const float VoicePitch)
+{
+	// a speaker row is keyed without its name, the name only tells apart the lines that have no row
+	FSpeakerKey Key{SpeakerTable, SpeakerRow, SpeakerRow.IsNone() ? Name : FString()};
+	if (const FSpeakerId* const SpeakerId = SpeakerIds.Find(Key))
+	{
+		// an edited speaker row is picked up by the next compile, unchanged fields keep the shared text
+		FDialogueSpeaker& Speaker = Speakers[*SpeakerId];
+		if (!Speaker.Name.ToString().Equals(Name, ESearchCase::CaseSensitive)) { Speaker.Name = FText::FromString(Name); }
+		Speaker.Voice = Voice;
+		Speaker.VoicePitch = VoicePitch;
+		return *SpeakerId;
+	}
+
+	if (Speakers.Num() >= InvalidSpeaker)
+	{
+		UE_LOG(LogSTQuestSystem, Error, TEXT("%s: Too many speakers, %s is dropped."), *FString(__FUNCTION__), *Name);
+		return InvalidSpeaker;
+	}
+
+	const FSpeakerId SpeakerId = static_cast<FSpeakerId>(Speakers.Add({FText::FromString(Name), {}, Voice, VoicePitch}));
+	SpeakerIds.Add(MoveTemp(Key), SpeakerId);
+	return SpeakerId;
+}
+
+FDialogueSpeakerRegistry::FPortraitIndex FDialogueSpeakerRegistry::InternPortrait(const FSpeakerId SpeakerId, const TSoftObjectPtr<UTexture2D>& Portrait)
+{
+	if (!IsValidSpeaker(SpeakerId)) { return InvalidPortrait; }
+
+	// a speaker has a handful of expressions, a linear search is enough
+	TArray<TSoftObjectPtr<UTexture2D>>& Portraits = Speakers[SpeakerId].Portraits;
+	if (const int32 ExistingIndex = Portraits.IndexOfByKey(Portrait); ExistingIndex != INDEX_NONE)
+	{
+		return static_cast<FPortraitIndex>(ExistingIndex);
+	}
+
+	if (Portraits.Num() >= InvalidPortrait)
+	{
+		UE_LOG(LogSTQuestSystem, Error, TEXT("%s: Too many portraits for %s, %s is dropped."), *FString(__FUNCTION__),
+		       *Speakers[SpeakerId].Name.ToString(), *Portrait.ToString());
+		return InvalidPortrait;
+	}
+
+	return static_cast<FPortraitIndex>(Portraits.Add(Portrait));
+}
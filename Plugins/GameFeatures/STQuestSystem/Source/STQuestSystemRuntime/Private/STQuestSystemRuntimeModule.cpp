@@ -2,18 +2,38 @@
 
 #include "STQuestSystemRuntimeModule.h"
 
+#include "Libs/DialogueLineStore.h"
+#include "Libs/DialogueSpeakerRegistry.h"
+#include "UI/DialogueWidgetPool.h"
+#include "Engine/World.h"
+
+DEFINE_LOG_CATEGORY(LogSTQuestSystem);
+
 #define LOCTEXT_NAMESPACE "FSTQuestSystemRuntimeModule"
 
 void FSTQuestSystemRuntimeModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory;
 	// the exact timing is specified in the .uplugin file per-module
+	StartGameInstanceHandle = FWorldDelegates::OnStartGameInstance.AddRaw(this, &FSTQuestSystemRuntimeModule::HandleStartGameInstance);
+	// the feature can be loaded after the game instance started
+	FDialogueWidgetPool::Get().Prewarm();
 }
 
 void FSTQuestSystemRuntimeModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.
 	// For modules that support dynamic reloading, we call this function before unloading the module.
+	FWorldDelegates::OnStartGameInstance.Remove(StartGameInstanceHandle);
+
+	FDialogueWidgetPool::TearDown();
+	FDialogueLineStore::TearDown();
+	FDialogueSpeakerRegistry::TearDown();
+}
+
+void FSTQuestSystemRuntimeModule::HandleStartGameInstance(UGameInstance* GameInstance)
+{
+	FDialogueWidgetPool::Get().Prewarm();
 }
 
 #undef LOCTEXT_NAMESPACE
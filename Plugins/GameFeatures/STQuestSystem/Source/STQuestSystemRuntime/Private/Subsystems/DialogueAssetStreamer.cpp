@@ -0,0 +1,191 @@
+﻿#include "Subsystems/DialogueAssetStreamer.h"
+
+#include "STQS_Structs.h"
+#include "STQuestSystemRuntimeModule.h"
+#include "Algo/AllOf.h"
+#include "Engine/AssetManager.h"
+#include "Libs/DialogueLineStore.h"
+
+void UDialogueAssetStreamer::Deinitialize()
+{
+	for (TPair<FSoftObjectPath, FStreamedAsset>& Pair : StreamedAssets)
+	{
+		if (Pair.Value.Handle.IsValid()) { Pair.Value.Handle->CancelHandle(); }
+	}
+	StreamedAssets.Reset();
+	PinnedAssets.Reset();
+	ResidentBytes = 0;
+
+	Super::Deinitialize();
+}
+
+void UDialogueAssetStreamer::BeginConversation(const UDataTable* DialogueTable, const TArray<FName>& LineRows, const int32 FirstLine,
+                                               const UObject* Owner)
+{
+	if (!IsValid(DialogueTable))
+	{
+		UE_LOG(LogSTQuestSystem, Error, TEXT("%s: DialogueTable is invalid."), *FString(__FUNCTION__));
+		return;
+	}
+
+	ConversationStore = FDialogueLineStore::Get(DialogueTable);
+	ConversationLines.Reset(LineRows.Num());
+	for (const FName RowName : LineRows)
+	{
+		// kept as a placeholder, the caller's line indices must keep pointing at the same rows
+		const int32 LineId = ConversationStore->FindLineId(RowName);
+		if (LineId == INDEX_NONE)
+		{
+			UE_LOG(LogSTQuestSystem, Warning, TEXT("%s: Row %s is not in %s."), *FString(__FUNCTION__), *RowName.ToString(), *DialogueTable->GetName());
+		}
+		ConversationLines.Add(LineId);
+	}
+	CurrentLine = INDEX_NONE;
+	ConversationOwner = Owner;
+
+	SetCurrentLine(FirstLine);
+}
+
+bool UDialogueAssetStreamer::IsConversationOwner(const UObject* Owner, const UDataTable* DialogueTable) const
+{
+	return Owner != nullptr && ConversationOwner.Get() == Owner && ConversationStore.IsValid()
+		&& ConversationStore == FDialogueLineStore::Get(DialogueTable);
+}
+
+void UDialogueAssetStreamer::SetCurrentLine(const int32 LineIndex)
+{
+	if (!ConversationStore.IsValid() || !ConversationLines.IsValidIndex(LineIndex)) { return; }
+
+	CurrentLine = LineIndex;
+	PinnedAssets.Reset();
+
+	TArray<FSoftObjectPath> AssetPaths;
+	const int32 LastLine = FMath::Min(LineIndex + PrefetchLineCount, ConversationLines.Num() - 1);
+	for (int32 Index = LineIndex; Index <= LastLine; ++Index)
+	{
+		if (ConversationLines[Index] == INDEX_NONE) { continue; }
+
+		AssetPaths.Reset();
+		GetLineAssetPaths(*ConversationStore, ConversationLines[Index], AssetPaths);
+		PinnedAssets.Append(AssetPaths);
+
+		// the shown line jumps the queue, the prefetched ones load behind it
+		RequestAssets(AssetPaths, Index == LineIndex ? FStreamableManager::AsyncLoadHighPriority : FStreamableManager::DefaultAsyncLoadPriority);
+	}
+
+	EvictOverBudget();
+}
+
+void UDialogueAssetStreamer::EndConversation()
+{
+	ConversationStore.Reset();
+	ConversationOwner.Reset();
+	ConversationLines.Reset();
+	CurrentLine = INDEX_NONE;
+	PinnedAssets.Reset();
+
+	EvictOverBudget();
+}
+
+void UDialogueAssetStreamer::RequestLineAssets(const FDialogueData& Line, FStreamableDelegate OnLoaded)
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	GetLineAssetPaths(Line, AssetPaths);
+	RequestAssets(AssetPaths, FStreamableManager::AsyncLoadHighPriority);
+
+	if (AreLineAssetsLoaded(Line))
+	{
+		OnLoaded.ExecuteIfBound();
+		return;
+	}
+
+	// joins the requests above, only carries the callback
+	UAssetManager::GetStreamableManager().RequestAsyncLoad(MoveTemp(AssetPaths), MoveTemp(OnLoaded), FStreamableManager::AsyncLoadHighPriority);
+}
+
+bool UDialogueAssetStreamer::AreLineAssetsLoaded(const FDialogueData& Line) const
+{
+	TArray<FSoftObjectPath> AssetPaths;
+	GetLineAssetPaths(Line, AssetPaths);
+	return Algo::AllOf(AssetPaths, [](const FSoftObjectPath& AssetPath) { return AssetPath.ResolveObject() != nullptr; });
+}
+
+void UDialogueAssetStreamer::GetLineAssetPaths(const FDialogueData& Line, TArray<FSoftObjectPath>& OutPaths)
+{
+	// read from the speaker row directly, a one off line isn't interned into the speaker registry
+	const FDialogueSpeakerData* const SpeakerData = Line.Speaker.IsNull() ? nullptr : Line.Speaker.GetRow<FDialogueSpeakerData>(TEXT("UDialogueAssetStreamer"));
+	if (SpeakerData != nullptr)
+	{
+		const TSoftObjectPtr<UTexture2D>* const Portrait = Line.Portrait.IsNone() ? nullptr : SpeakerData->Portraits.Find(Line.Portrait);
+		const TSoftObjectPtr<UTexture2D>& FaceImage = Portrait != nullptr ? *Portrait : SpeakerData->DefaultPortrait;
+		if (!FaceImage.IsNull()) { OutPaths.Add(FaceImage.ToSoftObjectPath()); }
+		if (!SpeakerData->Voice.IsNull()) { OutPaths.Add(SpeakerData->Voice.ToSoftObjectPath()); }
+	}
+	else if (!Line.FaceImage.IsNull()) { OutPaths.Add(Line.FaceImage.ToSoftObjectPath()); }
+
+	if (!Line.InteractSound.IsNull()) { OutPaths.Add(Line.InteractSound.ToSoftObjectPath()); }
+}
+
+void UDialogueAssetStreamer::GetLineAssetPaths(const FDialogueLineStore& Store, const int32 LineId, TArray<FSoftObjectPath>& OutPaths)
+{
+	if (!Store.GetFaceImage(LineId).IsNull()) { OutPaths.Add(Store.GetFaceImage(LineId).ToSoftObjectPath()); }
+	if (!Store.GetVoice(LineId).IsNull()) { OutPaths.Add(Store.GetVoice(LineId).ToSoftObjectPath()); }
+	if (!Store.GetInteractSound(LineId).IsNull()) { OutPaths.Add(Store.GetInteractSound(LineId).ToSoftObjectPath()); }
+}
+
+void UDialogueAssetStreamer::RequestAssets(TConstArrayView<FSoftObjectPath> AssetPaths, const TAsyncLoadPriority Priority)
+{
+	for (const FSoftObjectPath& AssetPath : AssetPaths)
+	{
+		FStreamedAsset& StreamedAsset = StreamedAssets.FindOrAdd(AssetPath);
+		StreamedAsset.LastUsed = ++UseCounter;
+		if (StreamedAsset.Handle.IsValid()) { continue; }
+
+		// one handle per asset so each one can be released on its own
+		StreamedAsset.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(
+			AssetPath, FStreamableDelegate::CreateUObject(this, &ThisClass::HandleAssetLoaded, AssetPath), Priority);
+	}
+}
+
+void UDialogueAssetStreamer::HandleAssetLoaded(FSoftObjectPath AssetPath)
+{
+	FStreamedAsset* const StreamedAsset = StreamedAssets.Find(AssetPath);
+	if (StreamedAsset == nullptr || !StreamedAsset->Handle.IsValid()) { return; }
+
+	UObject* const LoadedAsset = StreamedAsset->Handle->GetLoadedAsset();
+	if (!IsValid(LoadedAsset))
+	{
+		UE_LOG(LogSTQuestSystem, Warning, TEXT("%s: Failed to load %s."), *FString(__FUNCTION__), *AssetPath.ToString());
+		return;
+	}
+
+	StreamedAsset->SizeBytes = LoadedAsset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+	ResidentBytes += StreamedAsset->SizeBytes;
+
+	EvictOverBudget();
+}
+
+void UDialogueAssetStreamer::EvictOverBudget()
+{
+	const int64 BudgetBytes = static_cast<int64>(MemoryBudgetMB) * 1024 * 1024;
+	while (ResidentBytes > BudgetBytes)
+	{
+		// a conversation keeps few assets resident, a linear scan for the oldest one is cheaper than maintaining an ordered list
+		FSoftObjectPath EvictedPath;
+		uint64 OldestUse = MAX_uint64;
+		for (const TPair<FSoftObjectPath, FStreamedAsset>& Pair : StreamedAssets)
+		{
+			if (Pair.Value.SizeBytes > 0 && Pair.Value.LastUsed < OldestUse && !PinnedAssets.Contains(Pair.Key))
+			{
+				EvictedPath = Pair.Key;
+				OldestUse = Pair.Value.LastUsed;
+			}
+		}
+		if (EvictedPath.IsNull()) { return; }
+
+		FStreamedAsset EvictedAsset;
+		StreamedAssets.RemoveAndCopyValue(EvictedPath, EvictedAsset);
+		EvictedAsset.Handle->ReleaseHandle();
+		ResidentBytes -= EvictedAsset.SizeBytes;
+	}
+}
@@ -1,5 +1,13 @@
 ﻿#include "UI/DialogueWidgetBase.h"
 
+#include "Engine/GameInstance.h"
+#include "Engine/Texture2D.h"
+#include "Engine/World.h"
+#include "Libs/DialogueLineStore.h"
+#include "Subsystems/DialogueAssetStreamer.h"
+#include "UI/DialogueWidgetPool.h"
+#include "UI/SDialogueRevealText.h"
+
 UDialogueWidgetBase::UDialogueWidgetBase()
 {
 }
@@ -26,7 +34,7 @@ void SDialogueWidget::Construct(const FArguments& InArgs)
 		.HAlign(HAlign_Center)
 		[
 			SAssignNew(TargetNameWidget, STextBlock)
-			.Text(FText::FromString(TargetName))
+			.Text(TargetName)
 			.Font(FontInfo_Name)
 			.Justification(ETextJustify::Center)
 		]
@@ -61,54 +69,131 @@ void SDialogueWidget::Construct(const FArguments& InArgs)
 				.HAlign(HAlign_Fill)
 				.VAlign(VAlign_Fill)
 				[
-					SAssignNew(ContentTextWidget, STextBlock)
+					SAssignNew(ContentTextWidget, SDialogueRevealText)
 					.Font(FontInfo_Content)
-					.AutoWrapText(true)
-					.Text(FText::FromString(ContentText))
+					.Text(ContentText)
 				]
 			]
 		]
 	];
 }
 
+void SDialogueWidget::Rebind(const FArguments& InArgs)
+{
+	SkipReveal();
+
+	// every setter skips unchanged values, a tree reused for the same speaker and style only swaps the text
+	SetTargetName(InArgs._TargetName);
+	SetContentText(InArgs._ContentText);
+	SetTargetImage(InArgs._ImageBrush);
+	SetContentBGBrush(InArgs._ContentBGBrush);
+	SetContentBGColor(InArgs._ContentBGColor);
+	SetNameFontInfo(InArgs._FontInfo_Name);
+	SetContentFontInfo(InArgs._FontInfo_Content);
+}
+
 void SDialogueWidget::SetTargetImage(const FSlateBrush& InBrush)
 {
+	// same portrait as the previous line, nothing to invalidate
+	if (ImageBrush == InBrush) { return; }
+
 	ImageBrush = InBrush;
 	TargetIconWidget.Get()->SetImage(&ImageBrush);
 }
 
 void SDialogueWidget::SetContentBGColor(const FSlateColor& InSlateColor)
 {
+	if (ContentBGColor == InSlateColor) { return; }
+
 	ContentBGColor = InSlateColor;
 	ContentBGWidget->SetBorderBackgroundColor(ContentBGColor);
 }
 
 void SDialogueWidget::SetContentBGBrush(const FSlateBrush& InBrush)
 {
+	if (ContentBGBrush == InBrush) { return; }
+
 	ContentBGBrush = InBrush;
 	ContentBGWidget->SetBorderImage(&ContentBGBrush);
 }
 
 void SDialogueWidget::SetContentText(const FString& InContentText)
+{
+	SetContentText(FText::FromString(InContentText));
+}
+
+void SDialogueWidget::SetContentText(const FText& InContentText)
 {
 	ContentText = InContentText;
-	ContentTextWidget->SetText(FText::FromString(InContentText));
+	ContentTextWidget->SetText(ContentText);
+}
+
+void SDialogueWidget::StartReveal(const float CharactersPerSecond)
+{
+	RevealCharactersPerSecond = CharactersPerSecond;
+	RevealTime = 0.f;
+
+	if (CharactersPerSecond <= 0.f)
+	{
+		SkipReveal();
+		return;
+	}
+
+	ContentTextWidget->SetRevealedCharacters(0);
+	if (!RevealTimer.IsValid())
+	{
+		RevealTimer = RegisterActiveTimer(0.f, FWidgetActiveTimerDelegate::CreateSP(this, &SDialogueWidget::UpdateReveal));
+	}
+}
+
+void SDialogueWidget::SkipReveal()
+{
+	ContentTextWidget->SetRevealedCharacters(ContentTextWidget->GetNumCharacters());
+	if (RevealTimer.IsValid())
+	{
+		UnRegisterActiveTimer(RevealTimer.ToSharedRef());
+		RevealTimer.Reset();
+	}
+}
+
+EActiveTimerReturnType SDialogueWidget::UpdateReveal(double InCurrentTime, float InDeltaTime)
+{
+	RevealTime += InDeltaTime;
+	ContentTextWidget->SetRevealedCharacters(FMath::FloorToInt32(RevealTime * RevealCharactersPerSecond));
+
+	if (!ContentTextWidget->IsFullyRevealed()) { return EActiveTimerReturnType::Continue; }
+
+	RevealTimer.Reset();
+	return EActiveTimerReturnType::Stop;
 }
 
 void SDialogueWidget::SetTargetName(const FString& InTargetName)
 {
+	SetTargetName(FText::FromString(InTargetName));
+}
+
+void SDialogueWidget::SetTargetName(const FText& InTargetName)
+{
+	// interned speaker names are shared, consecutive lines of a speaker pass the same text
+	if (TargetName.IdenticalTo(InTargetName)) { return; }
+
 	TargetName = InTargetName;
-	TargetNameWidget->SetText(FText::FromString(InTargetName));
+	TargetNameWidget->SetText(TargetName);
 }
 
 void SDialogueWidget::SetContentFontInfo(const FSlateFontInfo& InFontInfo)
 {
+	// a new font lays the whole text out again
+	if (FontInfo_Content == InFontInfo) { return; }
+
 	FontInfo_Content = InFontInfo;
 	ContentTextWidget->SetFont(InFontInfo);
 }
 
 void SDialogueWidget::SetNameFontInfo(const FSlateFontInfo& InFontInfo)
 {
+	if (FontInfo_Name == InFontInfo) { return; }
+
 	FontInfo_Name = InFontInfo;
 	TargetNameWidget->SetFont(InFontInfo);
 }
@@ -126,11 +211,18 @@ void UDialogueWidgetBase::PostEditChangeProperty(struct FPropertyChangedEvent& E
 	if (Event.Property == nullptr || !DialogueWidget.IsValid()) { return; }
 	if (Event.GetPropertyName().IsEqual(GET_MEMBER_NAME_CHECKED(ThisClass, DialogueDataRowHandle)))
 	{
-		FDialogueData* DialogueData = DialogueDataRowHandle.GetRow<FDialogueData>(DialogueDataRowHandle.RowName.ToString());
-		DialogueWidget->SetContentText(DialogueData->ContentText);
-		DialogueWidget->SetTargetName(DialogueData->TargetName);
-		ImageBrush.SetResourceObject(DialogueData->FaceImage);
-		DialogueWidget->SetTargetImage(ImageBrush);
+		const TSharedRef<const FDialogueLineStore> Store = GetDialogueStore();
+		const int32 LineId = Store->FindLineId(DialogueDataRowHandle.RowName);
+		if (Store->IsValidLine(LineId))
+		{
+			DialogueWidget->SetContentText(Store->GetContentText(LineId));
+			DialogueWidget->SetTargetName(Store->GetTargetName(LineId));
+			// editor preview, the game streams portraits through UDialogueAssetStreamer
+			ImageBrush.SetResourceObject(Store->GetFaceImage(LineId).LoadSynchronous());
+			DialogueWidget->SetTargetImage(ImageBrush);
+			ShownSpeakerId = Store->GetSpeakerId(LineId);
+			ShownPortraitIndex = Store->GetPortraitIndex(LineId);
+		}
 	}
 	if (Event.GetPropertyName().IsEqual(GET_MEMBER_NAME_CHECKED(ThisClass, FontInfo_Name)))
 	{
@@ -154,6 +246,12 @@ void UDialogueWidgetBase::PostEditChangeProperty(struct FPropertyChangedEvent& E
 	}
 }
 
+TSharedRef<SWidget> UDialogueWidgetBase::RebuildDesignWidget(TSharedRef<SWidget> Content)
+{
+	return Super::RebuildDesignWidget(Content);
+}
+#endif
+
 TSharedRef<SWidget> UDialogueWidgetBase::RebuildWidget()
 {
 	if (!DialogueWidget.IsValid())
@@ -164,12 +262,6 @@ TSharedRef<SWidget> UDialogueWidgetBase::RebuildWidget()
 	return DialogueWidget.ToSharedRef();
 }
 
-TSharedRef<SWidget> UDialogueWidgetBase::RebuildDesignWidget(TSharedRef<SWidget> Content)
-{
-	return Super::RebuildDesignWidget(Content);
-}
-#endif
-
 void UDialogueWidgetBase::BeginDestroy()
 {
 	DialogueWidget.Reset();
@@ -181,23 +273,161 @@ void UDialogueWidgetBase::ReleaseSlateResources(bool bReleaseChildren)
 {
 	Super::ReleaseSlateResources(bReleaseChildren);
 	DialogueWidget.Reset();
+	EndStreamedConversation();
 }
 
 TSharedRef<SDialogueWidget> UDialogueWidgetBase::CreateDialogueWidget()
 {
-	if (DialogueDataRowHandle.IsNull())
+	const TSharedRef<const FDialogueLineStore> Store = GetDialogueStore();
+	const int32 LineId = Store->FindLineId(DialogueDataRowHandle.RowName);
+	// the new widget shows the designer's brush, the first line applies its speaker portrait
+	ShownSpeakerId = FDialogueSpeakerRegistry::InvalidSpeaker;
+	ShownPortraitIndex = FDialogueSpeakerRegistry::InvalidPortrait;
+	if (!Store->IsValidLine(LineId))
 	{
-		return SAssignNew(DialogueWidget, SDialogueWidget);
+		DialogueWidget = FDialogueWidgetPool::Get().Acquire(SDialogueWidget::FArguments());
+		return DialogueWidget.ToSharedRef();
 	}
-	FDialogueData* DialogueData = DialogueDataRowHandle.GetRow<FDialogueData>(DialogueDataRowHandle.RowName.ToString());
-	SAssignNew(DialogueWidget, SDialogueWidget)
-	.TargetName(DialogueData->TargetName)
-	.ContentText(DialogueData->ContentText)
-	.ImageBrush(ImageBrush)
-	.FontInfo_Name(FontInfo_Name)
-	.FontInfo_Content(FontInfo_Content)
-	.ContentBGBrush(ContentBGBrush)
-	.ContentBGColor(ContentBGColor);
+	DialogueWidget = FDialogueWidgetPool::Get().Acquire(SDialogueWidget::FArguments()
+		.TargetName(Store->GetTargetName(LineId))
+		.ContentText(Store->GetContentText(LineId))
+		.ImageBrush(ImageBrush)
+		.FontInfo_Name(FontInfo_Name)
+		.FontInfo_Content(FontInfo_Content)
+		.ContentBGBrush(ContentBGBrush)
+		.ContentBGColor(ContentBGColor));
 
 	return DialogueWidget.ToSharedRef();
 }
+
+int32 UDialogueWidgetBase::FindDialogueLineId(const FName RowName) const
+{
+	return GetDialogueStore()->FindLineId(RowName);
+}
+
+bool UDialogueWidgetBase::ShowDialogueLine(const int32 LineId)
+{
+	const TSharedRef<const FDialogueLineStore> Store = GetDialogueStore();
+	if (!Store->IsValidLine(LineId)) { return false; }
+
+	DialogueDataRowHandle.RowName = Store->GetRowName(LineId);
+	StreamConversationLine(*Store, LineId);
+	if (DialogueWidget.IsValid())
+	{
+		ApplyLine(*Store, LineId);
+	}
+	return true;
+}
+
+UDialogueAssetStreamer* UDialogueWidgetBase::GetAssetStreamer() const
+{
+	const UWorld* const World = GetWorld();
+	return IsValid(World) && World->GetGameInstance() != nullptr ? World->GetGameInstance()->GetSubsystem<UDialogueAssetStreamer>() : nullptr;
+}
+
+void UDialogueWidgetBase::StreamConversationLine(const FDialogueLineStore& Store, const int32 LineId)
+{
+	UDialogueAssetStreamer* const Streamer = GetAssetStreamer();
+	if (!IsValid(Streamer)) { return; }
+
+	// without explicit rows the conversation is the table itself, line ids follow its row order
+	const int32 LineIndex = ConversationRows.IsEmpty() ? LineId : ConversationRows.Find(Store.GetRowName(LineId));
+	if (LineIndex == INDEX_NONE) { return; }
+
+	if (Streamer->IsConversationOwner(this, DialogueDataRowHandle.DataTable) && StreamedConversationRows == ConversationRows)
+	{
+		Streamer->SetCurrentLine(LineIndex);
+		return;
+	}
+
+	StreamedConversationRows = ConversationRows;
+	TArray<FName> LineRows = ConversationRows;
+	if (LineRows.IsEmpty())
+	{
+		LineRows.Reserve(Store.Num());
+		for (int32 Id = 0; Id < Store.Num(); ++Id)
+		{
+			LineRows.Add(Store.GetRowName(Id));
+		}
+	}
+	Streamer->BeginConversation(DialogueDataRowHandle.DataTable, LineRows, LineIndex, this);
+}
+
+void UDialogueWidgetBase::EndStreamedConversation()
+{
+	// the streamer may already be gone with its game instance
+	UDialogueAssetStreamer* const Streamer = GetAssetStreamer();
+	if (IsValid(Streamer) && Streamer->IsConversationOwner(this, DialogueDataRowHandle.DataTable))
+	{
+		Streamer->EndConversation();
+	}
+	StreamedConversationRows.Reset();
+}
+
+TSharedRef<const FDialogueLineStore> UDialogueWidgetBase::GetDialogueStore() const
+{
+	return FDialogueLineStore::Get(DialogueDataRowHandle.DataTable);
+}
+
+void UDialogueWidgetBase::ApplyLine(const FDialogueLineStore& Store, const int32 LineId)
+{
+	DialogueWidget->SetContentText(Store.GetContentText(LineId));
+	DialogueWidget->StartReveal(RevealCharactersPerSecond);
+
+	// same speaker keeps its name, an expression change only swaps the portrait
+	const FDialogueSpeakerRegistry::FSpeakerId SpeakerId = Store.GetSpeakerId(LineId);
+	const FDialogueSpeakerRegistry::FPortraitIndex PortraitIndex = Store.GetPortraitIndex(LineId);
+	if (SpeakerId != ShownSpeakerId)
+	{
+		DialogueWidget->SetTargetName(Store.GetTargetName(LineId));
+	}
+	else if (PortraitIndex == ShownPortraitIndex) { return; }
+
+	ShownSpeakerId = SpeakerId;
+	ShownPortraitIndex = PortraitIndex;
+	ApplyFaceImage(Store.GetFaceImage(LineId));
+}
+
+void UDialogueWidgetBase::ApplyFaceImage(const TSoftObjectPtr<UTexture2D>& FaceImage)
+{
+	if (FaceImage.IsNull() || FaceImage.IsValid())
+	{
+		ImageBrush.SetResourceObject(FaceImage.Get());
+		DialogueWidget->SetTargetImage(ImageBrush);
+		return;
+	}
+
+	UDialogueAssetStreamer* const Streamer = GetAssetStreamer();
+	if (!IsValid(Streamer))
+	{
+		ImageBrush.SetResourceObject(FaceImage.LoadSynchronous());
+		DialogueWidget->SetTargetImage(ImageBrush);
+		return;
+	}
+
+	FDialogueData PortraitLine;
+	PortraitLine.FaceImage = FaceImage;
+	Streamer->RequestLineAssets(PortraitLine, FStreamableDelegate::CreateWeakLambda(this, [this, FaceImage]()
+	{
+		// the line may have moved on while the portrait streamed
+		const TSharedRef<const FDialogueLineStore> Store = GetDialogueStore();
+		const int32 LineId = Store->FindLineId(DialogueDataRowHandle.RowName);
+		if (!DialogueWidget.IsValid() || !Store->IsValidLine(LineId) || Store->GetFaceImage(LineId) != FaceImage) { return; }
+
+		ImageBrush.SetResourceObject(FaceImage.Get());
+		DialogueWidget->SetTargetImage(ImageBrush);
+	}));
+}
+
+void UDialogueWidgetBase::SkipReveal()
+{
+	if (DialogueWidget.IsValid())
+	{
+		DialogueWidget->SkipReveal();
+	}
+}
+
+bool UDialogueWidgetBase::IsRevealing() const
+{
+	return DialogueWidget.IsValid() && DialogueWidget->IsRevealing();
+}
@@ -0,0 +1,82 @@
+﻿#include "UI/DialogueWidgetPool.h"
+
+#include "Algo/Count.h"
+#include "Framework/Application/SlateApplication.h"
+#include "HAL/IConsoleManager.h"
+
+namespace DialogueWidgetPool
+{
+	FDialogueWidgetPool* Instance = nullptr;
+
+	int32 PoolSize = 2;
+	FAutoConsoleVariableRef CVarPoolSize(
+		TEXT("STQuest.Dialogue.WidgetPoolSize"),
+		PoolSize,
+		TEXT("Number of dialogue widgets kept constructed and reused across conversations."));
+
+	bool IsFree(const TSharedRef<SDialogueWidget>& Widget)
+	{
+		// only the pool references it, no dialogue widget or parent slot holds it
+		return Widget.GetSharedReferenceCount() == 1;
+	}
+}
+
+FDialogueWidgetPool& FDialogueWidgetPool::Get()
+{
+	check(IsInGameThread());
+
+	if (DialogueWidgetPool::Instance == nullptr)
+	{
+		DialogueWidgetPool::Instance = new FDialogueWidgetPool();
+	}
+
+	return *DialogueWidgetPool::Instance;
+}
+
+void FDialogueWidgetPool::TearDown()
+{
+	delete DialogueWidgetPool::Instance;
+	DialogueWidgetPool::Instance = nullptr;
+}
+
+void FDialogueWidgetPool::Prewarm()
+{
+	if (!FSlateApplication::IsInitialized()) { return; }
+
+	while (Widgets.Num() < DialogueWidgetPool::PoolSize)
+	{
+		Widgets.Add(SNew(SDialogueWidget));
+	}
+}
+
+TSharedRef<SDialogueWidget> FDialogueWidgetPool::Acquire(const SDialogueWidget::FArguments& Args)
+{
+	for (const TSharedRef<SDialogueWidget>& Widget : Widgets)
+	{
+		if (!DialogueWidgetPool::IsFree(Widget)) { continue; }
+
+		Widget->Rebind(Args);
+		return Widget;
+	}
+
+	const TSharedRef<SDialogueWidget> Widget = SNew(SDialogueWidget)
+		.TargetName(Args._TargetName)
+		.ContentText(Args._ContentText)
+		.ImageBrush(Args._ImageBrush)
+		.ContentBGBrush(Args._ContentBGBrush)
+		.ContentBGColor(Args._ContentBGColor)
+		.FontInfo_Name(Args._FontInfo_Name)
+		.FontInfo_Content(Args._FontInfo_Content);
+
+	// past the pool size the widget is simply not kept once released
+	if (Widgets.Num() < DialogueWidgetPool::PoolSize)
+	{
+		Widgets.Add(Widget);
+	}
+	return Widget;
+}
+
+int32 FDialogueWidgetPool::GetNumFree() const
+{
+	return Algo::CountIf(Widgets, &DialogueWidgetPool::IsFree);
+}
@@ -0,0 +1,198 @@
+﻿#include "UI/SDialogueRevealText.h"
+
+#include "Framework/Text/ILayoutBlock.h"
+#include "Framework/Text/IRun.h"
+#include "Framework/Text/PlainTextLayoutMarshaller.h"
+#include "Framework/Text/SlateTextLayout.h"
+#include "Styling/CoreStyle.h"
+
+SDialogueRevealText::SDialogueRevealText()
+{
+	// ticked only to follow the arranged width, like an auto wrapping STextBlock
+	SetCanTick(true);
+}
+
+SDialogueRevealText::~SDialogueRevealText() = default;
+
+void SDialogueRevealText::Construct(const FArguments& InArgs)
+{
+	TextStyle = FCoreStyle::Get().GetWidgetStyle<FTextBlockStyle>("NormalText");
+	TextStyle.SetFont(InArgs._Font);
+	Text = InArgs._Text;
+
+	Marshaller = FPlainTextLayoutMarshaller::Create();
+	TextLayout = FSlateTextLayout::Create(this, TextStyle);
+	TextLayout->SetWrappingPolicy(ETextWrappingPolicy::DefaultWrapping);
+
+	RebuildLayout();
+}
+
+void SDialogueRevealText::SetText(const FText& InText)
+{
+	if (Text.IdenticalTo(InText)) { return; }
+
+	Text = InText;
+	RebuildLayout();
+}
+
+void SDialogueRevealText::SetFont(const FSlateFontInfo& InFont)
+{
+	TextStyle.SetFont(InFont);
+	TextLayout->SetDefaultTextStyle(TextStyle);
+	RebuildLayout();
+}
+
+void SDialogueRevealText::SetRevealedCharacters(const int32 InRevealedCharacters)
+{
+	const int32 ClampedCharacters = FMath::Clamp(InRevealedCharacters, 0, NumCharacters);
+	if (ClampedCharacters == GetRevealedCharacters()) { return; }
+
+	RevealedCharacters = ClampedCharacters;
+	bRevealRectsDirty = true;
+
+	// the layout itself is untouched, only the clip rects of the next paint move
+	Invalidate(EInvalidateWidgetReason::Paint);
+}
+
+void SDialogueRevealText::RebuildLayout()
+{
+	const FString TextString = Text.ToString();
+
+	TextLayout->ClearLines();
+	Marshaller->SetText(TextString, *TextLayout);
+
+	// the marshaller makes one model line per source line
+	LineStarts.Reset();
+	int32 LineStart = 0;
+	for (const FTextLayout::FLineModel& LineModel : TextLayout->GetLineModels())
+	{
+		LineStarts.Add(LineStart);
+		LineStart += LineModel.Text->Len() + 1;
+	}
+
+	NumCharacters = TextString.Len();
+	RevealedCharacters = MAX_int32;
+	RevealLineIndex = 0;
+	bRevealRectsDirty = true;
+
+	Invalidate(EInvalidateWidgetReason::Layout);
+}
+
+FVector2D SDialogueRevealText::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	TextLayout->SetScale(LayoutScaleMultiplier);
+	TextLayout->SetWrappingWidth(WrapWidth);
+	TextLayout->UpdateIfNeeded();
+
+	return FVector2D(TextLayout->GetSize());
+}
+
+void SDialogueRevealText::Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime)
+{
+	// wrap at the width we were arranged with, ticked before this frame's paint so even the first one is wrapped
+	const float AllottedWidth = AllottedGeometry.GetLocalSize().X;
+	if (AllottedWidth <= 0.f || FMath::IsNearlyEqual(WrapWidth, AllottedWidth)) { return; }
+
+	WrapWidth = AllottedWidth;
+	TextLayout->SetWrappingWidth(WrapWidth);
+	TextLayout->UpdateIfNeeded();
+	bRevealRectsDirty = true;
+
+	// the wrapped height reaches the parent with the next prepass
+	Invalidate(EInvalidateWidgetReason::Layout);
+}
+
+int32 SDialogueRevealText::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect,
+                                   FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	const float AllottedWidth = AllottedGeometry.GetLocalSize().X;
+	if (IsFullyRevealed())
+	{
+		return TextLayout->OnPaint(Args, AllottedGeometry, MyCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled);
+	}
+
+	UpdateRevealRects();
+
+	const float InverseScale = Inverse(AllottedGeometry.Scale);
+	const float LayoutWidth = FMath::Max(AllottedWidth, TextLayout->GetSize().X * InverseScale);
+	int32 MaxLayerId = LayerId;
+
+	// the layout culls its lines against the rect it is given, narrowed to each clip so the hidden lines aren't emitted at all
+	const auto PaintClipped = [&](const FSlateRect& LocalClipRect)
+	{
+		const FSlateRect ClipRect = AllottedGeometry.GetLayoutBoundingRect(LocalClipRect);
+		bool bOverlapping = false;
+		const FSlateRect ClippedCullingRect = MyCullingRect.IntersectionWith(ClipRect, bOverlapping);
+		if (!bOverlapping) { return; }
+
+		OutDrawElements.PushClip(FSlateClippingZone(ClipRect));
+		MaxLayerId = FMath::Max(MaxLayerId, TextLayout->OnPaint(Args, AllottedGeometry, ClippedCullingRect, OutDrawElements, LayerId, InWidgetStyle, bParentEnabled));
+		OutDrawElements.PopClip();
+	};
+
+	// every line above the reveal point is painted whole
+	if (RevealedLinesBottom > 0.f)
+	{
+		PaintClipped(FSlateRect(0.f, 0.f, LayoutWidth, RevealedLinesBottom * InverseScale));
+	}
+
+	if (PartialLineRect.bIsValid)
+	{
+		PaintClipped(FSlateRect(PartialLineRect.Min.X * InverseScale, PartialLineRect.Min.Y * InverseScale,
+		                        PartialLineRect.Max.X * InverseScale, PartialLineRect.Max.Y * InverseScale));
+	}
+
+	return MaxLayerId;
+}
+
+void SDialogueRevealText::UpdateRevealRects() const
+{
+	if (!bRevealRectsDirty) { return; }
+	bRevealRectsDirty = false;
+
+	RevealedLinesBottom = 0.f;
+	PartialLineRect = FBox2f(ForceInit);
+
+	const TArray<FTextLayout::FLineView>& LineViews = TextLayout->GetLineViews();
+	if (LineViews.IsEmpty()) { return; }
+
+	const auto GetLineEnd = [this, &LineViews](const int32 Index)
+	{
+		return LineStarts[LineViews[Index].ModelIndex] + LineViews[Index].Range.EndIndex;
+	};
+
+	// a reveal step moves by a few characters, walk from the line of the previous step instead of the first one
+	int32 Index = FMath::Clamp(RevealLineIndex, 0, LineViews.Num() - 1);
+	while (Index > 0 && RevealedCharacters < GetLineEnd(Index - 1)) { --Index; }
+	while (Index < LineViews.Num() && RevealedCharacters >= GetLineEnd(Index)) { ++Index; }
+	RevealLineIndex = Index;
+
+	if (Index > 0)
+	{
+		RevealedLinesBottom = LineViews[Index - 1].Offset.Y + LineViews[Index - 1].Size.Y;
+	}
+	if (Index == LineViews.Num()) { return; }
+
+	// only the line holding the reveal point is measured
+	const FTextLayout::FLineView& LineView = LineViews[Index];
+	const int32 LineBegin = LineStarts[LineView.ModelIndex] + LineView.Range.BeginIndex;
+	if (RevealedCharacters <= LineBegin) { return; }
+
+	const int32 RevealIndex = RevealedCharacters - LineStarts[LineView.ModelIndex];
+	float RevealX = LineView.Offset.X;
+	for (const TSharedRef<ILayoutBlock>& Block : LineView.Blocks)
+	{
+		const FTextRange BlockRange = Block->GetTextRange();
+		if (RevealIndex >= BlockRange.EndIndex)
+		{
+			RevealX = Block->GetLocationOffset().X + Block->GetSize().X;
+			continue;
+		}
+
+		const FVector2D RevealedSize = Block->GetRun()->Measure(BlockRange.BeginIndex, RevealIndex, TextLayout->GetScale(), Block->GetTextContext());
+		RevealX = Block->GetLocationOffset().X + RevealedSize.X;
+		break;
+	}
+
+	PartialLineRect = FBox2f(FVector2f(LineView.Offset.X, LineView.Offset.Y), FVector2f(RevealX, LineView.Offset.Y + LineView.Size.Y));
+}
@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "UObject/SoftObjectPtr.h"
+#include "Libs/DialogueSpeakerRegistry.h"
+
+class UDataTable;
+class UTexture2D;
+class USoundBase;
+
+/*
+ * FDialogueData rows of a table packed into parallel arrays addressed by dense line ids.
+ * Row names are resolved to ids once, stepping through a conversation is then an array index instead of a row lookup.
+ * Stores are compiled on first use and shared until the table changes or goes away.
+ */
+class STQUESTSYSTEMRUNTIME_API FDialogueLineStore
+{
+public:
+	/* Compiled store of the table, an empty store when the table is null or doesn't hold FDialogueData rows */
+	static TSharedRef<const FDialogueLineStore> Get(const UDataTable* DialogueTable);
+	static void TearDown();
+
+	/* INDEX_NONE when the table has no such row */
+	int32 FindLineId(const FName RowName) const;
+
+	int32 Num() const { return RowNames.Num(); }
+	bool IsValidLine(const int32 LineId) const { return RowNames.IsValidIndex(LineId); }
+
+	FName GetRowName(const int32 LineId) const { return RowNames[LineId]; }
+	const FText& GetContentText(const int32 LineId) const { return ContentTexts[LineId]; }
+
+	/* Lines of the same speaker share the id, FDialogueSpeakerRegistry::InvalidSpeaker when it couldn't be interned */
+	FDialogueSpeakerRegistry::FSpeakerId GetSpeakerId(const int32 LineId) const { return LineSpeakers[LineId].SpeakerId; }
+	/* Portrait of the line among its speaker's, lines of a speaker with the same expression share it */
+	FDialogueSpeakerRegistry::FPortraitIndex GetPortraitIndex(const int32 LineId) const { return LineSpeakers[LineId].PortraitIndex; }
+	const FText& GetTargetName(const int32 LineId) const;
+	const TSoftObjectPtr<UTexture2D>& GetFaceImage(const int32 LineId) const;
+	const TSoftObjectPtr<USoundBase>& GetVoice(const int32 LineId) const;
+	const TSoftObjectPtr<USoundBase>& GetInteractSound(const int32 LineId) const { return InteractSounds[LineId]; }
+
+private:
+	void Compile(const UDataTable& DialogueTable);
+
+	static void HandleDataTableChanged(TObjectKey<UDataTable> TableKey);
+
+	TArray<FName> RowNames;
+	TMap<FName, int32> LineIds;
+
+	// text is built once here, not from the row strings every time a line is shown
+	TArray<FText> ContentTexts;
+	// name and portraits live in the speaker registry, once per speaker
+	TArray<FDialogueSpeakerRegistry::FLineSpeaker> LineSpeakers;
+	TArray<TSoftObjectPtr<USoundBase>> InteractSounds;
+};
@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/SoftObjectPtr.h"
+
+class UTexture2D;
+class USoundBase;
+struct FDialogueData;
+
+/* Interned speaker, shared by every line of the same speaker row (or of the same name for lines without one) */
+struct FDialogueSpeaker
+{
+	FText Name;
+	// every portrait its lines use, a line keeps the index of its own
+	TArray<TSoftObjectPtr<UTexture2D>> Portraits;
+	TSoftObjectPtr<USoundBase> Voice;
+	float VoicePitch = 1.f;
+};
+
+/*
+ * Process wide table of the speakers of every compiled dialogue line.
+ * A game has a few dozen speakers for thousands of lines, lines keep a 16 bit speaker id and an 8 bit portrait index into it.
+ */
+class STQUESTSYSTEMRUNTIME_API FDialogueSpeakerRegistry
+{
+public:
+	using FSpeakerId = uint16;
+	static constexpr FSpeakerId InvalidSpeaker = MAX_uint16;
+
+	/* Index into FDialogueSpeaker::Portraits, an expression change keeps the speaker and only moves this */
+	using FPortraitIndex = uint8;
+	static constexpr FPortraitIndex InvalidPortrait = MAX_uint8;
+
+	struct FLineSpeaker
+	{
+		FSpeakerId SpeakerId = InvalidSpeaker;
+		FPortraitIndex PortraitIndex = InvalidPortrait;
+	};
+
+	static FDialogueSpeakerRegistry& Get();
+	static void TearDown();
+
+	/* Speaker of the line, resolved from its speaker row or from its own name and face image when it has none */
+	FLineSpeaker InternLineSpeaker(const FDialogueData& Line);
+
+	bool IsValidSpeaker(const FSpeakerId SpeakerId) const { return Speakers.IsValidIndex(SpeakerId); }
+	const FDialogueSpeaker& GetSpeaker(const FSpeakerId SpeakerId) const { return Speakers[SpeakerId]; }
+	int32 Num() const { return Speakers.Num(); }
+
+private:
+	FSpeakerId Intern(const FSoftObjectPath& SpeakerTable, const FName SpeakerRow, const FString& Name, const TSoftObjectPtr<USoundBase>& Voice,
+	                  const float VoicePitch);
+	FPortraitIndex InternPortrait(const FSpeakerId SpeakerId, const TSoftObjectPtr<UTexture2D>& Portrait);
+
+	/* The speaker row, or only the name for lines without one. Portrait and voice aren't part of it */
+	struct FSpeakerKey
+	{
+		FSoftObjectPath SpeakerTable;
+		FName SpeakerRow;
+		FString Name;
+
+		bool operator==(const FSpeakerKey& Other) const
+		{
+			return SpeakerRow == Other.SpeakerRow && SpeakerTable == Other.SpeakerTable && Name.Equals(Other.Name, ESearchCase::CaseSensitive);
+		}
+		friend uint32 GetTypeHash(const FSpeakerKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.SpeakerTable), GetTypeHash(Key.SpeakerRow)), GetTypeHash(Key.Name));
+		}
+	};
+
+	TArray<FDialogueSpeaker> Speakers;
+	TMap<FSpeakerKey, FSpeakerId> SpeakerIds;
+};
@@ -4,14 +4,51 @@
 #include "Engine/DataTable.h"
 #include "STQS_Structs.generated.h"
 
+class UTexture2D;
+class USoundBase;
+
+/* A character speaking dialogue lines, defined once and referenced by every line it speaks */
+USTRUCT(BlueprintType, Blueprintable)
+struct FDialogueSpeakerData : public FTableRowBase
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Speaker")
+	FString Name;
+
+	/* Portrait used when the line doesn't pick one of Portraits */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Speaker")
+	TSoftObjectPtr<UTexture2D> DefaultPortrait;
+
+	/* Alternative portraits (expressions, outfits) selected by FDialogueData::Portrait */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Speaker")
+	TMap<FName, TSoftObjectPtr<UTexture2D>> Portraits;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Speaker")
+	TSoftObjectPtr<USoundBase> Voice;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Speaker")
+	float VoicePitch = 1.f;
+};
+
 USTRUCT(BlueprintType, Blueprintable)
 struct FDialogueData : public FTableRowBase
 {
 	GENERATED_BODY()
 
+	/* Row of a speaker table, lines of the same speaker share its name and portraits */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Data", meta=(RowType="/Script/STQuestSystemRuntime.DialogueSpeakerData"))
+	FDataTableRowHandle Speaker;
+
+	/* Key into the speaker's Portraits, None uses its default portrait */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Data")
+	FName Portrait;
+
+	/* Used when no Speaker is set. Streamed with the line by UDialogueAssetStreamer, not loaded with the table */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Data")
-	UTexture2D* FaceImage;
+	TSoftObjectPtr<UTexture2D> FaceImage;
 
+	/* Used when no Speaker is set */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Data")
 	FString TargetName;
 
@@ -19,5 +56,5 @@ struct FDialogueData : public FTableRowBase
 	FString ContentText;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Dialogue | Data")
-	USoundBase* InteractSound;
+	TSoftObjectPtr<USoundBase> InteractSound;
 };
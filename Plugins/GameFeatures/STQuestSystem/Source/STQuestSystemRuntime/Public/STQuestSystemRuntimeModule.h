@@ -5,6 +5,10 @@
 #include "CoreMinimal.h"
 #include "Modules/ModuleManager.h"
 
+class UGameInstance;
+
+STQUESTSYSTEMRUNTIME_API DECLARE_LOG_CATEGORY_EXTERN(LogSTQuestSystem, Log, All);
+
 class FSTQuestSystemRuntimeModule : public IModuleInterface
 {
 public:
@@ -12,4 +16,9 @@ public:
 	virtual void StartupModule() override;
 	virtual void ShutdownModule() override;
 	//~End of IModuleInterface
+
+private:
+	// dialogue widgets are constructed before the first conversation opens
+	void HandleStartGameInstance(UGameInstance* GameInstance);
+	FDelegateHandle StartGameInstanceHandle;
 };
@@ -0,0 +1,83 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StreamableManager.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "DialogueAssetStreamer.generated.h"
+
+class UDataTable;
+class FDialogueLineStore;
+struct FDialogueData;
+
+/*
+ * Streams the portraits and sounds of dialogue lines on demand.
+ * The current line of the active conversation is requested first and the following lines are prefetched behind it,
+ * assets outside of that window stay resident until the budget is exceeded and are then released least recently used first.
+ */
+UCLASS(Config = Game)
+class STQUESTSYSTEMRUNTIME_API UDialogueAssetStreamer : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	/* Lines of the conversation in the order they are shown, FirstLine becomes the current line. Owner identifies the conversation for IsConversationOwner */
+	UFUNCTION(BlueprintCallable, Category = "Dialogue | Streaming")
+	void BeginConversation(const UDataTable* DialogueTable, const TArray<FName>& LineRows, const int32 FirstLine = 0, const UObject* Owner = nullptr);
+
+	/* True while the conversation Owner began on DialogueTable is the active one */
+	bool IsConversationOwner(const UObject* Owner, const UDataTable* DialogueTable) const;
+
+	/* Request the assets of the line and prefetch the lines following it */
+	UFUNCTION(BlueprintCallable, Category = "Dialogue | Streaming")
+	void SetCurrentLine(const int32 LineIndex);
+
+	/* The assets of the conversation stay cached, they become the first candidates for eviction */
+	UFUNCTION(BlueprintCallable, Category = "Dialogue | Streaming")
+	void EndConversation();
+
+	/* OnLoaded is called once the assets of the line are resident, right away when they already are */
+	void RequestLineAssets(const FDialogueData& Line, FStreamableDelegate OnLoaded);
+
+	bool AreLineAssetsLoaded(const FDialogueData& Line) const;
+
+	int64 GetResidentBytes() const { return ResidentBytes; }
+
+	/* Number of lines after the current one whose assets are loaded ahead */
+	UPROPERTY(Config, EditAnywhere, Category = "Dialogue | Streaming", meta = (ClampMin = "0"))
+	int32 PrefetchLineCount = 3;
+
+	/* Memory the streamed assets may use before the least recently used ones outside of the prefetch window are released */
+	UPROPERTY(Config, EditAnywhere, Category = "Dialogue | Streaming", meta = (ClampMin = "0"))
+	int32 MemoryBudgetMB = 64;
+
+private:
+	struct FStreamedAsset
+	{
+		TSharedPtr<FStreamableHandle> Handle;
+		// measured once the asset is loaded, 0 while it streams
+		int64 SizeBytes = 0;
+		uint64 LastUsed = 0;
+	};
+
+	static void GetLineAssetPaths(const FDialogueData& Line, TArray<FSoftObjectPath>& OutPaths);
+	static void GetLineAssetPaths(const FDialogueLineStore& Store, const int32 LineId, TArray<FSoftObjectPath>& OutPaths);
+
+	void RequestAssets(TConstArrayView<FSoftObjectPath> AssetPaths, const TAsyncLoadPriority Priority);
+	void HandleAssetLoaded(FSoftObjectPath AssetPath);
+	void EvictOverBudget();
+
+	TMap<FSoftObjectPath, FStreamedAsset> StreamedAssets;
+	// assets of the current line and the prefetched ones, never evicted
+	TSet<FSoftObjectPath> PinnedAssets;
+
+	TSharedPtr<const FDialogueLineStore> ConversationStore;
+	TWeakObjectPtr<const UObject> ConversationOwner;
+	// line ids of the conversation in the caller's order, INDEX_NONE for rows missing from the table
+	TArray<int32> ConversationLines;
+	int32 CurrentLine = INDEX_NONE;
+
+	uint64 UseCounter = 0;
+	int64 ResidentBytes = 0;
+};
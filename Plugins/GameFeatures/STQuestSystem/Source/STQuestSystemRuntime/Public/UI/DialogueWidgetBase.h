@@ -5,6 +5,10 @@
 #include "Components/Widget.h"
 #include "DialogueWidgetBase.generated.h"
 
+class FDialogueLineStore;
+class SDialogueRevealText;
+class UDialogueAssetStreamer;
+
 DECLARE_DELEGATE(FOnDialoguePaintEvent);
 
 class SDialogueWidget : public SCompoundWidget
@@ -12,8 +16,8 @@ class SDialogueWidget : public SCompoundWidget
 	SLATE_BEGIN_ARGS(SDialogueWidget)
 		{
 		};
-		SLATE_ARGUMENT(FString, TargetName);
-		SLATE_ARGUMENT(FString, ContentText);
+		SLATE_ARGUMENT(FText, TargetName);
+		SLATE_ARGUMENT(FText, ContentText);
 		SLATE_ARGUMENT(FSlateBrush, ImageBrush);
 		SLATE_ARGUMENT(FSlateBrush, ContentBGBrush);
 		SLATE_ARGUMENT(FSlateColor, ContentBGColor);
@@ -30,10 +34,20 @@ public:
 	void SetContentBGColor(const FSlateColor& InSlateColor);
 	void SetContentBGBrush(const FSlateBrush& InBrush);
 	void SetContentText(const FString& InContentText);
+	void SetContentText(const FText& InContentText);
 	void SetContentFontInfo(const FSlateFontInfo& InFontInfo);
 	void SetTargetName(const FString& InTargetName);
+	void SetTargetName(const FText& InTargetName);
 	void SetNameFontInfo(const FSlateFontInfo& InFontInfo);
 
+	/* Show new arguments in the constructed tree, used to reuse pooled widgets */
+	void Rebind(const FArguments& InArgs);
+
+	/* Reveal the content text from its first character, CharactersPerSecond <= 0 shows it whole */
+	void StartReveal(const float CharactersPerSecond);
+	void SkipReveal();
+	bool IsRevealing() const { return RevealTimer.IsValid(); }
+
 	FSlateFontInfo FontInfo_Name;
 	FSlateFontInfo FontInfo_Content;
 	FSlateBrush ImageBrush;
@@ -41,13 +55,19 @@ public:
 	FSlateColor ContentBGColor;
 
 private:
-	FString TargetName = TEXT("Name");
-	FString ContentText = TEXT("Content");
+	FText TargetName = INVTEXT("Name");
+	FText ContentText = INVTEXT("Content");
 
 	TSharedPtr<STextBlock> TargetNameWidget;
 	TSharedPtr<SImage> TargetIconWidget;
-	TSharedPtr<STextBlock> ContentTextWidget;
+	TSharedPtr<SDialogueRevealText> ContentTextWidget;
 	TSharedPtr<SBorder> ContentBGWidget;
+
+	EActiveTimerReturnType UpdateReveal(double InCurrentTime, float InDeltaTime);
+
+	TSharedPtr<FActiveTimerHandle> RevealTimer;
+	float RevealCharactersPerSecond = 0.f;
+	float RevealTime = 0.f;
 };
 
 UCLASS()
@@ -62,10 +82,12 @@ public:
 	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
 
 protected:
-	virtual TSharedRef<SWidget> RebuildWidget() override;
 	virtual TSharedRef<SWidget> RebuildDesignWidget(TSharedRef<SWidget> Content) override;
 #endif
 
+protected:
+	virtual TSharedRef<SWidget> RebuildWidget() override;
+
 public:
 	UDialogueWidgetBase();
 	virtual void BeginDestroy() override;
@@ -74,6 +96,29 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DialogueWidget | Data")
 	FDataTableRowHandle DialogueDataRowHandle;
 
+	/* Id of a row of the DialogueDataRowHandle table, resolve it once and step through the conversation with ids */
+	UFUNCTION(BlueprintPure, Category = "DialogueWidget | Data")
+	int32 FindDialogueLineId(const FName RowName) const;
+
+	/* Rows of the conversation in the order they are shown, their assets are prefetched ahead of the shown line. Empty follows the table's row order */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DialogueWidget | Data")
+	TArray<FName> ConversationRows;
+
+	/* Show a line of the DialogueDataRowHandle table, returns false when the id is out of range */
+	UFUNCTION(BlueprintCallable, Category = "DialogueWidget | Data")
+	bool ShowDialogueLine(const int32 LineId);
+
+	/* Speed lines shown by ShowDialogueLine are typed out at, 0 shows them whole */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DialogueWidget | Data", meta = (ClampMin = "0"))
+	float RevealCharactersPerSecond = 0.f;
+
+	/* Show the rest of the line being typed out */
+	UFUNCTION(BlueprintCallable, Category = "DialogueWidget | Data")
+	void SkipReveal();
+
+	UFUNCTION(BlueprintPure, Category = "DialogueWidget | Data")
+	bool IsRevealing() const;
+
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DialogueWidget | Data")
 	FSlateFontInfo FontInfo_Name = FCoreStyle::Get().GetFontStyle("Roboto");
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "DialogueWidget | Data")
@@ -87,7 +132,24 @@ public:
 	FSlateColor ContentBGColor = FCoreStyle::Get().GetColor("Gary");
 
 private:
+	// borrowed from FDialogueWidgetPool, back in the pool once released
 	TSharedPtr<SDialogueWidget> DialogueWidget;
 
+	// compiled lines of the DialogueDataRowHandle table
+	TSharedRef<const FDialogueLineStore> GetDialogueStore() const;
+	void ApplyLine(const FDialogueLineStore& Store, const int32 LineId);
+	void ApplyFaceImage(const TSoftObjectPtr<UTexture2D>& FaceImage);
+
+	UDialogueAssetStreamer* GetAssetStreamer() const;
+	// begin this widget's conversation on the streamer when another one took over, then move it to the line
+	void StreamConversationLine(const FDialogueLineStore& Store, const int32 LineId);
+	void EndStreamedConversation();
+	// ConversationRows the streamer's conversation was begun with
+	TArray<FName> StreamedConversationRows;
+
+	// speaker whose name DialogueWidget shows, and which of its portraits
+	uint16 ShownSpeakerId = MAX_uint16;
+	uint8 ShownPortraitIndex = MAX_uint8;
+
 	TSharedRef<SDialogueWidget> CreateDialogueWidget();
 };
@@ -0,0 +1,27 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "UI/DialogueWidgetBase.h"
+
+/*
+ * Keeps a few SDialogueWidget trees constructed and hands them out to dialogue widgets.
+ * A pooled widget is free again once the pool holds its only reference, it is then rebound to the next line instead of rebuilt.
+ */
+class STQUESTSYSTEMRUNTIME_API FDialogueWidgetPool
+{
+public:
+	static FDialogueWidgetPool& Get();
+	static void TearDown();
+
+	/* Construct widgets until the pool holds its configured size, does nothing before Slate is up */
+	void Prewarm();
+
+	/* A free pooled widget rebound to Args, a new one when every pooled widget is in use */
+	TSharedRef<SDialogueWidget> Acquire(const SDialogueWidget::FArguments& Args);
+
+	int32 Num() const { return Widgets.Num(); }
+	int32 GetNumFree() const;
+
+private:
+	TArray<TSharedRef<SDialogueWidget>> Widgets;
+};
@@ -0,0 +1,70 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "Styling/SlateTypes.h"
+#include "Widgets/SLeafWidget.h"
+
+class FSlateTextLayout;
+class FPlainTextLayoutMarshaller;
+
+/*
+ * Wrapped text revealed character by character (typewriter).
+ * The whole text is shaped and wrapped once when it is set, revealing more characters only moves the clip rects the layout is painted in,
+ * so a step costs the same for a short or a long line. Left to right, left justified text only.
+ */
+class STQUESTSYSTEMRUNTIME_API SDialogueRevealText : public SLeafWidget
+{
+	SLATE_BEGIN_ARGS(SDialogueRevealText)
+		{
+		};
+		SLATE_ARGUMENT(FText, Text);
+		SLATE_ARGUMENT(FSlateFontInfo, Font);
+	SLATE_END_ARGS()
+
+public:
+	SDialogueRevealText();
+	virtual ~SDialogueRevealText() override;
+
+	void Construct(const FArguments& InArgs);
+
+	/* Lay the text out and reveal all of it */
+	void SetText(const FText& InText);
+	void SetFont(const FSlateFontInfo& InFont);
+
+	/* Characters shown from the start of the text, newlines included */
+	void SetRevealedCharacters(const int32 InRevealedCharacters);
+	int32 GetRevealedCharacters() const { return FMath::Min(RevealedCharacters, NumCharacters); }
+	int32 GetNumCharacters() const { return NumCharacters; }
+	bool IsFullyRevealed() const { return RevealedCharacters >= NumCharacters; }
+
+	//~SWidget
+	virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements,
+	                      int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+	//~End of SWidget
+
+private:
+	void RebuildLayout();
+	// the fully revealed block of lines and the partially revealed line, in layout space
+	void UpdateRevealRects() const;
+
+	FText Text;
+	FTextBlockStyle TextStyle;
+
+	TSharedPtr<FSlateTextLayout> TextLayout;
+	TSharedPtr<FPlainTextLayoutMarshaller> Marshaller;
+
+	// first character of every model line, maps the reveal count to a line and an offset in it
+	TArray<int32> LineStarts;
+	int32 NumCharacters = 0;
+	int32 RevealedCharacters = MAX_int32;
+
+	// width of the last arranged geometry, picked up in Tick before the paint that uses it
+	float WrapWidth = 0.f;
+	mutable bool bRevealRectsDirty = true;
+	// first line view not fully revealed, the walk to the new reveal point starts there
+	mutable int32 RevealLineIndex = 0;
+	mutable float RevealedLinesBottom = 0.f;
+	mutable FBox2f PartialLineRect = FBox2f(ForceInit);
+};
@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "InputSettingsCoreModule.h"
+
+#include "Libs/InputLatencyTracker.h"
+#include "Libs/InputNativeBindingRegistry.h"
+
+DEFINE_LOG_CATEGORY(LogInputSettings);
+
+UE_TRACE_CHANNEL_DEFINE(InputSettingsChannel);
+
+#define LOCTEXT_NAMESPACE "FInputSettingsCoreModule"
+
+void FInputSettingsCoreModule::StartupModule()
+{
+}
+
+void FInputSettingsCoreModule::ShutdownModule()
+{
+	FInputNativeBindingRegistry::TearDown();
+	FInputLatencyTracker::TearDown();
+}
+
+#undef LOCTEXT_NAMESPACE
+
+IMPLEMENT_MODULE(FInputSettingsCoreModule, InputSettingsCore)
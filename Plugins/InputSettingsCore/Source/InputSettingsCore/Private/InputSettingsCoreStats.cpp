@@ -0,0 +1,4 @@
+﻿#include "InputSettingsCoreStats.h"
+
+DEFINE_STAT(STAT_InputSettings_LiveMappingContexts);
+DEFINE_STAT(STAT_InputSettings_AvoidedMappingRebuilds);
@@ -0,0 +1,296 @@
+﻿#include "Libs/InputLatencyTracker.h"
+
+#include "HAL/IConsoleManager.h"
+#include "InputSettingsCoreModule.h"
+#include "Misc/CoreDelegates.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Trace/Trace.inl"
+
+CSV_DEFINE_CATEGORY(InputLatency, false);
+
+UE_TRACE_EVENT_BEGIN(InputSettings, LatencyFrame)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint8, Source)
+	UE_TRACE_EVENT_FIELD(uint8, Stage)
+	UE_TRACE_EVENT_FIELD(uint32, NumSamples)
+	UE_TRACE_EVENT_FIELD(float, P50Ms)
+	UE_TRACE_EVENT_FIELD(float, P99Ms)
+UE_TRACE_EVENT_END()
+
+bool FInputLatencyTracker::bEnabled = false;
+
+FAutoConsoleVariableRef FInputLatencyTracker::EnableCVar(
+	TEXT("InputSettings.Latency.Enable"), bEnabled,
+	TEXT("Stamp input events from the frame start to the character movement update and export the latency per frame."),
+	FConsoleVariableDelegate::CreateLambda([](IConsoleVariable*)
+	{
+		// the tracker hooks the frame delegates when created, it is only created once tracking is wanted
+		if (FInputLatencyTracker::IsEnabled())
+		{
+			FInputLatencyTracker::Get();
+		}
+	}));
+
+namespace InputLatencyTracker
+{
+	FInputLatencyTracker* Instance = nullptr;
+
+	float P99BudgetMs = 0.f;
+
+	FAutoConsoleVariableRef CVarP99BudgetMs(
+		TEXT("InputSettings.Latency.P99BudgetMs"), P99BudgetMs,
+		TEXT("Warn whenever the frame p99 of the total input to movement latency exceeds this many milliseconds, 0 disables the check."));
+
+	const TCHAR* const SourceNames[] = {TEXT("Reflected"), TEXT("Native")};
+	const TCHAR* const StageNames[] = {TEXT("Pump"), TEXT("Dispatch"), TEXT("Handler"), TEXT("Movement"), TEXT("Total")};
+
+	float GetSortedPercentile(const TArray<float>& SortedSamples, const float Percentile)
+	{
+		const int32 Index = FMath::Clamp(FMath::CeilToInt32(Percentile * SortedSamples.Num()) - 1, 0, SortedSamples.Num() - 1);
+		return SortedSamples[Index];
+	}
+}
+
+FInputLatencyTracker& FInputLatencyTracker::Get()
+{
+	if (InputLatencyTracker::Instance == nullptr)
+	{
+		InputLatencyTracker::Instance = new FInputLatencyTracker();
+	}
+
+	return *InputLatencyTracker::Instance;
+}
+
+void FInputLatencyTracker::TearDown()
+{
+	delete InputLatencyTracker::Instance;
+	InputLatencyTracker::Instance = nullptr;
+}
+
+FInputLatencyTracker::FInputLatencyTracker()
+{
+	ResetSession();
+
+	BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddRaw(this, &FInputLatencyTracker::HandleBeginFrame);
+	EndFrameHandle = FCoreDelegates::OnEndFrame.AddRaw(this, &FInputLatencyTracker::HandleEndFrame);
+}
+
+FInputLatencyTracker::~FInputLatencyTracker()
+{
+	FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+	FCoreDelegates::OnEndFrame.Remove(EndFrameHandle);
+}
+
+void FInputLatencyTracker::MarkInputProcessing()
+{
+	if (!IsEnabled()) { return; }
+
+	InputProcessingCycles = FPlatformTime::Cycles64();
+}
+
+void FInputLatencyTracker::BeginDispatch(const EInputLatencySource Source)
+{
+	if (DispatchDepth++ > 0 || !IsEnabled()) { return; }
+
+	OpenEventIndex = FrameEvents.Num();
+	FEventStamps& Event = FrameEvents.AddDefaulted_GetRef();
+	Event.DispatchCycles = FPlatformTime::Cycles64();
+	Event.Source = Source;
+}
+
+void FInputLatencyTracker::EndDispatch()
+{
+	DispatchDepth = FMath::Max(DispatchDepth - 1, 0);
+	if (DispatchDepth == 0)
+	{
+		OpenEventIndex = INDEX_NONE;
+	}
+}
+
+void FInputLatencyTracker::MarkMovementInput()
+{
+	if (!IsEnabled()) { return; }
+
+	const uint64 Cycles = FPlatformTime::Cycles64();
+	if (FrameEvents.IsValidIndex(OpenEventIndex))
+	{
+		FEventStamps& Event = FrameEvents[OpenEventIndex];
+		if (Event.MovementInputCycles == 0)
+		{
+			Event.MovementInputCycles = Cycles;
+		}
+		return;
+	}
+
+	// look and jump events of the frame are left alone, they never reach the movement component
+	for (FEventStamps& Event : FrameEvents)
+	{
+		if (Event.bMovementInputDeferred && Event.MovementInputCycles == 0)
+		{
+			Event.MovementInputCycles = Cycles;
+		}
+	}
+}
+
+void FInputLatencyTracker::MarkMovementInputDeferred()
+{
+	if (!IsEnabled() || !FrameEvents.IsValidIndex(OpenEventIndex)) { return; }
+
+	FrameEvents[OpenEventIndex].bMovementInputDeferred = true;
+}
+
+void FInputLatencyTracker::MarkMovementUpdate()
+{
+	// nothing to measure against before the first frame start was seen
+	if (!IsEnabled() || FrameStartCycles == 0) { return; }
+
+	const uint64 Cycles = FPlatformTime::Cycles64();
+	const bool bHasInputProcessing = InputProcessingCycles > FrameStartCycles;
+
+	for (FEventStamps& Event : FrameEvents)
+	{
+		if (Event.bCompleted || Event.MovementInputCycles == 0) { continue; }
+		Event.bCompleted = true;
+
+		TArray<float>(&Samples)[static_cast<int32>(EInputLatencyStage::Num)] = FrameSamples[static_cast<int32>(Event.Source)];
+		const auto AddSample = [&Samples](const EInputLatencyStage Stage, const uint64 FromCycles, const uint64 ToCycles)
+		{
+			Samples[static_cast<int32>(Stage)].Add(static_cast<float>(FPlatformTime::ToMilliseconds64(ToCycles - FromCycles)));
+		};
+
+		if (bHasInputProcessing)
+		{
+			AddSample(EInputLatencyStage::Pump, FrameStartCycles, InputProcessingCycles);
+		}
+		AddSample(EInputLatencyStage::Dispatch, bHasInputProcessing ? InputProcessingCycles : FrameStartCycles, Event.DispatchCycles);
+		AddSample(EInputLatencyStage::Handler, Event.DispatchCycles, Event.MovementInputCycles);
+		AddSample(EInputLatencyStage::Movement, Event.MovementInputCycles, Cycles);
+		AddSample(EInputLatencyStage::Total, FrameStartCycles, Cycles);
+	}
+}
+
+float FInputLatencyTracker::GetSessionPercentileMs(const EInputLatencySource Source, const EInputLatencyStage Stage, const float Percentile) const
+{
+	const FStageHistogram& Histogram = SessionHistograms[static_cast<int32>(Source)][static_cast<int32>(Stage)];
+	if (Histogram.NumSamples == 0) { return 0.f; }
+
+	const uint32 TargetCount = FMath::Max<uint32>(1, FMath::CeilToInt32(Percentile * Histogram.NumSamples));
+	uint32 Count = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; ++Bucket)
+	{
+		Count += Histogram.Buckets[Bucket];
+		if (Count >= TargetCount)
+		{
+			// upper edge of the bucket, never reports less than the real value
+			return static_cast<float>((Bucket + 1) * BucketMs);
+		}
+	}
+
+	return static_cast<float>(NumBuckets * BucketMs);
+}
+
+int32 FInputLatencyTracker::GetSessionNumSamples(const EInputLatencySource Source) const
+{
+	return SessionHistograms[static_cast<int32>(Source)][static_cast<int32>(EInputLatencyStage::Total)].NumSamples;
+}
+
+void FInputLatencyTracker::ResetSession()
+{
+	for (FStageHistogram(&SourceHistograms)[static_cast<int32>(EInputLatencyStage::Num)] : SessionHistograms)
+	{
+		for (FStageHistogram& Histogram : SourceHistograms)
+		{
+			Histogram.Buckets.Init(0, NumBuckets);
+			Histogram.NumSamples = 0;
+		}
+	}
+}
+
+void FInputLatencyTracker::LogSessionReport() const
+{
+	for (int32 Source = 0; Source < static_cast<int32>(EInputLatencySource::Num); ++Source)
+	{
+		const EInputLatencySource LatencySource = static_cast<EInputLatencySource>(Source);
+		UE_LOG(LogInputSettings, Display, TEXT("%s: %s, %d events."), *FString(__FUNCTION__), InputLatencyTracker::SourceNames[Source],
+		       GetSessionNumSamples(LatencySource));
+
+		for (int32 Stage = 0; Stage < static_cast<int32>(EInputLatencyStage::Num); ++Stage)
+		{
+			const EInputLatencyStage LatencyStage = static_cast<EInputLatencyStage>(Stage);
+			UE_LOG(LogInputSettings, Display, TEXT("%s:   %-8s p50 %6.2fms  p99 %6.2fms"), *FString(__FUNCTION__), InputLatencyTracker::StageNames[Stage],
+			       GetSessionPercentileMs(LatencySource, LatencyStage, 0.5f), GetSessionPercentileMs(LatencySource, LatencyStage, 0.99f));
+		}
+	}
+}
+
+void FInputLatencyTracker::HandleBeginFrame()
+{
+	FrameStartCycles = FPlatformTime::Cycles64();
+	FrameEvents.Reset();
+	DispatchDepth = 0;
+	OpenEventIndex = INDEX_NONE;
+}
+
+void FInputLatencyTracker::HandleEndFrame()
+{
+	if (!IsEnabled()) { return; }
+
+	const uint64 Cycle = FPlatformTime::Cycles64();
+	for (int32 Source = 0; Source < static_cast<int32>(EInputLatencySource::Num); ++Source)
+	{
+		for (int32 Stage = 0; Stage < static_cast<int32>(EInputLatencyStage::Num); ++Stage)
+		{
+			TArray<float>& Samples = FrameSamples[Source][Stage];
+			if (Samples.IsEmpty()) { continue; }
+
+			FStageHistogram& Histogram = SessionHistograms[Source][Stage];
+			for (const float SampleMs : Samples)
+			{
+				++Histogram.Buckets[FMath::Min(static_cast<int32>(SampleMs / BucketMs), NumBuckets - 1)];
+			}
+			Histogram.NumSamples += Samples.Num();
+
+			Samples.Sort();
+			const float P50Ms = InputLatencyTracker::GetSortedPercentile(Samples, 0.5f);
+			const float P99Ms = InputLatencyTracker::GetSortedPercentile(Samples, 0.99f);
+
+			UE_TRACE_LOG(InputSettings, LatencyFrame, InputSettingsChannel)
+				<< LatencyFrame.Cycle(Cycle)
+				<< LatencyFrame.Source(static_cast<uint8>(Source))
+				<< LatencyFrame.Stage(static_cast<uint8>(Stage))
+				<< LatencyFrame.NumSamples(Samples.Num())
+				<< LatencyFrame.P50Ms(P50Ms)
+				<< LatencyFrame.P99Ms(P99Ms);
+
+#if CSV_PROFILER
+			// Reflected_Total_P99 etc, one column per source, stage and percentile
+			const FString StatPrefix = FString::Printf(TEXT("%s_%s_"), InputLatencyTracker::SourceNames[Source], InputLatencyTracker::StageNames[Stage]);
+			FCsvProfiler::RecordCustomStat(*(StatPrefix + TEXT("P50")), CSV_CATEGORY_INDEX(InputLatency), P50Ms, ECsvCustomStatOp::Set);
+			FCsvProfiler::RecordCustomStat(*(StatPrefix + TEXT("P99")), CSV_CATEGORY_INDEX(InputLatency), P99Ms, ECsvCustomStatOp::Set);
+#endif
+
+			if (Stage == static_cast<int32>(EInputLatencyStage::Total) && InputLatencyTracker::P99BudgetMs > 0.f
+				&& P99Ms > InputLatencyTracker::P99BudgetMs)
+			{
+				UE_LOG(LogInputSettings, Warning, TEXT("%s: %s input to movement p99 %.2fms over the %.2fms budget."), *FString(__FUNCTION__),
+				       InputLatencyTracker::SourceNames[Source], P99Ms, InputLatencyTracker::P99BudgetMs);
+			}
+
+			Samples.Reset();
+		}
+	}
+}
+
+#if INPUTSETTINGS_WITH_LATENCY_TRACKING
+
+static FAutoConsoleCommand GInputLatencyReportCommand(
+	TEXT("InputSettings.Latency.Report"),
+	TEXT("Log the session p50/p99 input latency of every stage, reflected and native bindings apart."),
+	FConsoleCommandDelegate::CreateLambda([]() { FInputLatencyTracker::Get().LogSessionReport(); }));
+
+static FAutoConsoleCommand GInputLatencyResetCommand(
+	TEXT("InputSettings.Latency.Reset"),
+	TEXT("Clear the session input latency histograms."),
+	FConsoleCommandDelegate::CreateLambda([]() { FInputLatencyTracker::Get().ResetSession(); }));
+
+#endif
@@ -0,0 +1,82 @@
+﻿#include "Libs/InputNativeBindingRegistry.h"
+
+#include "Misc/ScopeRWLock.h"
+
+namespace InputNativeBindingRegistry
+{
+	FInputNativeBindingRegistry* Instance = nullptr;
+}
+
+FInputNativeBindingRegistry& FInputNativeBindingRegistry::Get()
+{
+	if (InputNativeBindingRegistry::Instance == nullptr)
+	{
+		InputNativeBindingRegistry::Instance = new FInputNativeBindingRegistry();
+	}
+
+	return *InputNativeBindingRegistry::Instance;
+}
+
+void FInputNativeBindingRegistry::TearDown()
+{
+	delete InputNativeBindingRegistry::Instance;
+	InputNativeBindingRegistry::Instance = nullptr;
+}
+
+void FInputNativeBindingRegistry::Unregister(const UClass* OwnerClass, const FName FunctionName)
+{
+	{
+		FWriteScopeLock WriteLock(BindersLock);
+
+		TArray<FRegisteredBinder, TInlineAllocator<1>>* const NameBinders = Binders.Find(FunctionName);
+		if (NameBinders == nullptr) { return; }
+
+		NameBinders->RemoveAll([OwnerClass](const FRegisteredBinder& Registered) { return Registered.OwnerClass == OwnerClass; });
+		if (NameBinders->IsEmpty())
+		{
+			Binders.Remove(FunctionName);
+		}
+	}
+
+	// plans may hold the removed binder
+	OnBindersChanged.Broadcast();
+}
+
+TSharedPtr<const FInputNativeBinder> FInputNativeBindingRegistry::Find(const UClass* OwnerClass, const FName FunctionName) const
+{
+	FReadScopeLock ReadLock(BindersLock);
+
+	const TArray<FRegisteredBinder, TInlineAllocator<1>>* const NameBinders = Binders.Find(FunctionName);
+	if (NameBinders == nullptr) { return nullptr; }
+
+	// walk up from the owner class so an override registered on a subclass wins
+	for (const UClass* Class = OwnerClass; Class != nullptr; Class = Class->GetSuperClass())
+	{
+		for (const FRegisteredBinder& Registered : *NameBinders)
+		{
+			if (Registered.OwnerClass == Class) { return Registered.Binder; }
+		}
+	}
+
+	return nullptr;
+}
+
+void FInputNativeBindingRegistry::RegisterBinder(const UClass* OwnerClass, const FName FunctionName, FInputNativeBinder&& Binder)
+{
+	check(IsValid(OwnerClass) && OwnerClass->HasAnyClassFlags(CLASS_Native));
+
+	{
+		FWriteScopeLock WriteLock(BindersLock);
+
+		TArray<FRegisteredBinder, TInlineAllocator<1>>& NameBinders = Binders.FindOrAdd(FunctionName);
+		if (FRegisteredBinder* const Existing = NameBinders.FindByPredicate(
+			[OwnerClass](const FRegisteredBinder& Registered) { return Registered.OwnerClass == OwnerClass; }))
+		{
+			Existing->Binder = MakeShared<const FInputNativeBinder>(MoveTemp(Binder));
+		}
+		else { NameBinders.Add({OwnerClass, MakeShared<const FInputNativeBinder>(MoveTemp(Binder))}); }
+	}
+
+	// plans compiled before the registration still point at the reflected function
+	OnBindersChanged.Broadcast();
+}
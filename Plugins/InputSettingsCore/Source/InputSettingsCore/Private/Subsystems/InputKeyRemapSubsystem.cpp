@@ -0,0 +1,332 @@
+﻿#include "Subsystems/InputKeyRemapSubsystem.h"
+
+#include "Algo/AnyOf.h"
+#include "EnhancedInputSubsystems.h"
+#include "Engine/LocalPlayer.h"
+#include "InputAction.h"
+#include "InputMappingContext.h"
+#include "InputSettingsCoreModule.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Subsystems/InputMappingContextRegistry.h"
+
+namespace InputKeyRemapSubsystem
+{
+	constexpr uint32 BlobMagic = 0x4F524B49; // "IKRO"
+	constexpr uint8 BlobVersion = 1;
+	constexpr int32 MaxOverrides = 4096;
+	// longest action path or key name accepted from a blob, in characters
+	constexpr int32 MaxStringLength = 1024;
+}
+
+void UInputKeyRemapSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Collection.InitializeDependency<UInputMappingContextRegistry>();
+
+	LoadOverrides();
+}
+
+void UInputKeyRemapSubsystem::Deinitialize()
+{
+	// the last write must reach the disk before the player is gone
+	SaveTask.Wait();
+
+	Super::Deinitialize();
+}
+
+bool UInputKeyRemapSubsystem::RemapKey(const UInputAction* Action, const FKey DefaultKey, const FKey Key)
+{
+	if (!IsValid(Action) || !DefaultKey.IsValid() || !Key.IsValid()) { return false; }
+	if (Key == DefaultKey) { return ResetKey(Action, DefaultKey); }
+
+	const FOverrideKey OverrideKey{FSoftObjectPath(Action), DefaultKey};
+	if (const FKey* const ExistingKey = KeyOverrides.Find(OverrideKey); ExistingKey != nullptr && *ExistingKey == Key) { return false; }
+
+	KeyOverrides.Add(OverrideKey, Key);
+	ApplyOverrideChanges(MakeArrayView(&OverrideKey, 1));
+	SaveOverrides();
+	return true;
+}
+
+bool UInputKeyRemapSubsystem::ResetKey(const UInputAction* Action, const FKey DefaultKey)
+{
+	if (!IsValid(Action)) { return false; }
+
+	const FOverrideKey OverrideKey{FSoftObjectPath(Action), DefaultKey};
+	if (KeyOverrides.Remove(OverrideKey) == 0) { return false; }
+
+	ApplyOverrideChanges(MakeArrayView(&OverrideKey, 1));
+	SaveOverrides();
+	return true;
+}
+
+void UInputKeyRemapSubsystem::ResetAllKeys()
+{
+	if (KeyOverrides.IsEmpty()) { return; }
+
+	TArray<FOverrideKey> ChangedKeys;
+	KeyOverrides.GenerateKeyArray(ChangedKeys);
+	KeyOverrides.Reset();
+
+	ApplyOverrideChanges(ChangedKeys);
+	SaveOverrides();
+}
+
+FKey UInputKeyRemapSubsystem::GetMappedKey(const UInputAction* Action, const FKey DefaultKey) const
+{
+	const FKey* const Key = IsValid(Action) ? KeyOverrides.Find({FSoftObjectPath(Action), DefaultKey}) : nullptr;
+	return Key != nullptr ? *Key : DefaultKey;
+}
+
+TArray<FInputKeyOverride> UInputKeyRemapSubsystem::GetKeyOverrides() const
+{
+	TArray<FInputKeyOverride> Overrides;
+	Overrides.Reserve(KeyOverrides.Num());
+	for (const TPair<FOverrideKey, FKey>& Pair : KeyOverrides)
+	{
+		Overrides.Add({TSoftObjectPtr<UInputAction>(Pair.Key.Action), Pair.Key.DefaultKey, Pair.Value});
+	}
+	return Overrides;
+}
+
+const UInputMappingContext* UInputKeyRemapSubsystem::GetRemappedContext(const UInputMappingContext* MappingContext)
+{
+	if (!IsValid(MappingContext) || KeyOverrides.IsEmpty()) { return MappingContext; }
+	if (UnaffectedContexts.Contains(MappingContext)) { return MappingContext; }
+
+	if (const TObjectPtr<UInputMappingContext>* const RemappedContext = RemappedContexts.Find(MappingContext))
+	{
+		return *RemappedContext;
+	}
+
+	UInputMappingContext* const RemappedContext = CreateRemappedContext(MappingContext);
+	if (RemappedContext == nullptr)
+	{
+		UnaffectedContexts.Add(MappingContext);
+		return MappingContext;
+	}
+
+	RemappedContexts.Add(MappingContext, RemappedContext);
+	return RemappedContext;
+}
+
+void UInputKeyRemapSubsystem::SerializeOverrides(const TArray<FInputKeyOverride>& Overrides, TArray<uint8>& OutBlob)
+{
+	FMemoryWriter Writer(OutBlob);
+
+	uint32 Magic = InputKeyRemapSubsystem::BlobMagic;
+	uint8 Version = InputKeyRemapSubsystem::BlobVersion;
+	int32 NumOverrides = Overrides.Num();
+	Writer << Magic << Version << NumOverrides;
+
+	for (const FInputKeyOverride& Override : Overrides)
+	{
+		FString ActionPath = Override.Action.ToString();
+		FString DefaultKeyName = Override.DefaultKey.GetFName().ToString();
+		FString KeyName = Override.Key.GetFName().ToString();
+		Writer << ActionPath << DefaultKeyName << KeyName;
+	}
+}
+
+bool UInputKeyRemapSubsystem::DeserializeOverrides(TConstArrayView<uint8> Blob, TArray<FInputKeyOverride>& OutOverrides)
+{
+	if (Blob.IsEmpty()) { return false; }
+
+	TArray<uint8> BlobData(Blob.GetData(), Blob.Num());
+	FMemoryReader Reader(BlobData);
+	// the blob comes from disk, a corrupt length fails the read instead of allocating whatever it claims
+	Reader.ArMaxSerializeSize = InputKeyRemapSubsystem::MaxStringLength;
+
+	uint32 Magic = 0;
+	uint8 Version = 0;
+	int32 NumOverrides = 0;
+	Reader << Magic << Version << NumOverrides;
+	if (Reader.IsError() || Magic != InputKeyRemapSubsystem::BlobMagic || Version != InputKeyRemapSubsystem::BlobVersion
+		|| NumOverrides < 0 || NumOverrides > InputKeyRemapSubsystem::MaxOverrides)
+	{
+		return false;
+	}
+
+	OutOverrides.Reserve(NumOverrides);
+	for (int32 Index = 0; Index < NumOverrides && !Reader.IsError(); ++Index)
+	{
+		FString ActionPath;
+		FString DefaultKeyName;
+		FString KeyName;
+		Reader << ActionPath << DefaultKeyName << KeyName;
+		if (Reader.IsError()) { break; }
+
+		OutOverrides.Add({TSoftObjectPtr<UInputAction>(FSoftObjectPath(ActionPath)), FKey(*DefaultKeyName), FKey(*KeyName)});
+	}
+
+	return !Reader.IsError();
+}
+
+bool UInputKeyRemapSubsystem::DoesContextMapKey(const UInputMappingContext* MappingContext, const FSoftObjectPath& Action, const FKey& DefaultKey)
+{
+	for (const FEnhancedActionKeyMapping& Mapping : MappingContext->GetMappings())
+	{
+		if (Mapping.Key == DefaultKey && FSoftObjectPath(Mapping.Action.Get()) == Action) { return true; }
+	}
+
+	return false;
+}
+
+UInputMappingContext* UInputKeyRemapSubsystem::CreateRemappedContext(const UInputMappingContext* MappingContext) const
+{
+	TArray<TPair<int32, FKey>, TInlineAllocator<8>> RemappedIndices;
+	const TArray<FEnhancedActionKeyMapping>& Mappings = MappingContext->GetMappings();
+	for (int32 Index = 0; Index < Mappings.Num(); ++Index)
+	{
+		if (const FKey* const Key = KeyOverrides.Find({FSoftObjectPath(Mappings[Index].Action.Get()), Mappings[Index].Key}))
+		{
+			RemappedIndices.Add({Index, *Key});
+		}
+	}
+	if (RemappedIndices.IsEmpty()) { return nullptr; }
+
+	// the copy owns duplicates of the instanced triggers and modifiers, they move over with the mapping
+	UInputMappingContext* const RemappedContext = DuplicateObject<UInputMappingContext>(
+		MappingContext, const_cast<UInputKeyRemapSubsystem*>(this),
+		MakeUniqueObjectName(const_cast<UInputKeyRemapSubsystem*>(this), UInputMappingContext::StaticClass(), MappingContext->GetFName()));
+
+	TArray<FEnhancedActionKeyMapping, TInlineAllocator<8>> RemappedMappings;
+	for (const TPair<int32, FKey>& RemappedIndex : RemappedIndices)
+	{
+		RemappedMappings.Add(RemappedContext->GetMappings()[RemappedIndex.Key]);
+	}
+	for (const FEnhancedActionKeyMapping& Mapping : RemappedMappings)
+	{
+		RemappedContext->UnmapKey(Mapping.Action, Mapping.Key);
+	}
+	for (int32 Index = 0; Index < RemappedMappings.Num(); ++Index)
+	{
+		const FEnhancedActionKeyMapping& Mapping = RemappedMappings[Index];
+		FEnhancedActionKeyMapping& NewMapping = RemappedContext->MapKey(Mapping.Action, RemappedIndices[Index].Value);
+		NewMapping.Triggers = Mapping.Triggers;
+		NewMapping.Modifiers = Mapping.Modifiers;
+	}
+
+	UE_LOG(LogInputSettings, Verbose, TEXT("%s: %s remapped, %d mappings changed."), *FString(__FUNCTION__), *MappingContext->GetName(),
+	       RemappedMappings.Num());
+	return RemappedContext;
+}
+
+void UInputKeyRemapSubsystem::ApplyOverrideChanges(TConstArrayView<FOverrideKey> ChangedKeys)
+{
+	UInputMappingContextRegistry* const Registry = ULocalPlayer::GetSubsystem<UInputMappingContextRegistry>(GetLocalPlayer());
+	UEnhancedInputLocalPlayerSubsystem* const Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer());
+
+	// a context that doesn't map a changed key keeps its copy, or stays unaffected
+	UnaffectedContexts.Reset();
+	for (auto It = RemappedContexts.CreateIterator(); It; ++It)
+	{
+		const UInputMappingContext* const MappingContext = It.Key();
+		if (!IsValid(MappingContext)
+			|| Algo::AnyOf(ChangedKeys, [MappingContext](const FOverrideKey& Key) { return DoesContextMapKey(MappingContext, Key.Action, Key.DefaultKey); }))
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (!IsValid(Registry) || !IsValid(Subsystem)) { return; }
+
+	FModifyContextOptions DeferredOptions;
+	DeferredOptions.bForceImmediately = false;
+
+	TArray<const UInputMappingContext*> LiveContexts;
+	Registry->GetMappingContexts(LiveContexts);
+
+	bool bChanged = false;
+	for (const UInputMappingContext* const MappingContext : LiveContexts)
+	{
+		bChanged |= Registry->RefreshMappingContext(MappingContext, DeferredOptions);
+	}
+
+	// only the swapped contexts were touched, one rebuild picks them up
+	if (bChanged)
+	{
+		FModifyContextOptions RebuildOptions;
+		RebuildOptions.bForceImmediately = true;
+		Subsystem->RequestRebuildControlMappings(RebuildOptions);
+	}
+}
+
+void UInputKeyRemapSubsystem::LoadOverrides()
+{
+	bLoadingOverrides = true;
+
+	const UE::Tasks::TTask<TArray<FInputKeyOverride>> LoadTask = UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[FilePath = GetSaveFilePath()]()
+		{
+			TArray<FInputKeyOverride> LoadedOverrides;
+			TArray<uint8> Blob;
+			if (FFileHelper::LoadFileToArray(Blob, *FilePath, FILEREAD_Silent) && !DeserializeOverrides(Blob, LoadedOverrides))
+			{
+				UE_LOG(LogInputSettings, Warning, TEXT("UInputKeyRemapSubsystem: %s is not a valid key override blob, ignored."), *FilePath);
+				LoadedOverrides.Reset();
+			}
+			return LoadedOverrides;
+		});
+
+	UE::Tasks::Launch(UE_SOURCE_LOCATION,
+		[WeakThis = TWeakObjectPtr<UInputKeyRemapSubsystem>(this), LoadTask]() mutable
+		{
+			if (UInputKeyRemapSubsystem* const This = WeakThis.Get())
+			{
+				This->HandleOverridesLoaded(MoveTemp(LoadTask.GetResult()));
+			}
+		},
+		UE::Tasks::Prerequisites(LoadTask), LowLevelTasks::ETaskPriority::Normal, UE::Tasks::EExtendedTaskPriority::GameThreadNormalPri);
+}
+
+void UInputKeyRemapSubsystem::HandleOverridesLoaded(TArray<FInputKeyOverride>&& LoadedOverrides)
+{
+	bLoadingOverrides = false;
+
+	TArray<FOverrideKey> ChangedKeys;
+	for (FInputKeyOverride& Override : LoadedOverrides)
+	{
+		// remapped while the blob was loading, the newer choice wins
+		FOverrideKey OverrideKey{Override.Action.ToSoftObjectPath(), Override.DefaultKey};
+		if (KeyOverrides.Contains(OverrideKey) || !Override.Key.IsValid()) { continue; }
+
+		KeyOverrides.Add(OverrideKey, Override.Key);
+		ChangedKeys.Add(MoveTemp(OverrideKey));
+	}
+
+	if (!ChangedKeys.IsEmpty())
+	{
+		ApplyOverrideChanges(ChangedKeys);
+	}
+}
+
+void UInputKeyRemapSubsystem::SaveOverrides()
+{
+	TArray<uint8> Blob;
+	SerializeOverrides(GetKeyOverrides(), Blob);
+
+	auto WriteBlob = [FilePath = GetSaveFilePath(), Blob = MoveTemp(Blob)]()
+	{
+		if (!FFileHelper::SaveArrayToFile(Blob, *FilePath))
+		{
+			UE_LOG(LogInputSettings, Error, TEXT("UInputKeyRemapSubsystem: Failed to write %s."), *FilePath);
+		}
+	};
+
+	SaveTask = SaveTask.IsValid()
+		           ? UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(WriteBlob), UE::Tasks::Prerequisites(SaveTask))
+		           : UE::Tasks::Launch(UE_SOURCE_LOCATION, MoveTemp(WriteBlob));
+}
+
+FString UInputKeyRemapSubsystem::GetSaveFilePath() const
+{
+	const ULocalPlayer* const LocalPlayer = GetLocalPlayer();
+	const int32 UserIndex = IsValid(LocalPlayer) ? LocalPlayer->GetPlatformUserIndex() : 0;
+
+	return FPaths::ProjectSavedDir() / TEXT("InputSettings") / FString::Printf(TEXT("KeyOverrides_%d.bin"), UserIndex);
+}
@@ -0,0 +1,253 @@
+﻿#include "Subsystems/InputMappingContextRegistry.h"
+
+#include "EnhancedInputSubsystems.h"
+#include "Engine/LocalPlayer.h"
+#include "InputMappingContext.h"
+#include "InputSettingsCoreStats.h"
+#include "Subsystems/InputKeyRemapSubsystem.h"
+
+namespace InputMappingContextRegistry
+{
+	int32 NumAvoidedRebuilds = 0;
+	int32 NumMappingRebuildRequests = 0;
+
+	void CountAvoidedRebuild()
+	{
+		++NumAvoidedRebuilds;
+		INC_DWORD_STAT(STAT_InputSettings_AvoidedMappingRebuilds);
+	}
+}
+
+UInputMappingContextRegistry* UInputMappingContextRegistry::Get(const UEnhancedInputLocalPlayerSubsystem* Subsystem)
+{
+	if (!IsValid(Subsystem)) { return nullptr; }
+
+	return ULocalPlayer::GetSubsystem<UInputMappingContextRegistry>(Subsystem->GetLocalPlayer());
+}
+
+bool UInputMappingContextRegistry::AddMappingContext(const UInputMappingContext* MappingContext, const int32 Priority,
+                                                     const FModifyContextOptions& Options)
+{
+	if (!IsValid(MappingContext)) { return false; }
+
+	UEnhancedInputLocalPlayerSubsystem* const Subsystem = GetInputSubsystem();
+	if (!IsValid(Subsystem)) { return false; }
+
+	FContextRefs& Refs = Contexts.FindOrAdd(MappingContext);
+	const bool bFirstReference = Refs.Priorities.IsEmpty();
+
+	int32 InsertIndex = 0;
+	while (InsertIndex < Refs.Priorities.Num() && Refs.Priorities[InsertIndex].Priority > Priority)
+	{
+		++InsertIndex;
+	}
+	if (InsertIndex < Refs.Priorities.Num() && Refs.Priorities[InsertIndex].Priority == Priority)
+	{
+		++Refs.Priorities[InsertIndex].Count;
+	}
+	else { Refs.Priorities.Insert({Priority, 1}, InsertIndex); }
+
+	// already applied at an equal or higher priority, the subsystem has nothing to rebuild
+	if (!bFirstReference && Refs.AppliedPriority >= Priority)
+	{
+		InputMappingContextRegistry::CountAvoidedRebuild();
+		return false;
+	}
+
+	if (bFirstReference)
+	{
+		Refs.AppliedContext = GetEffectiveContext(MappingContext);
+	}
+	Refs.AppliedPriority = Priority;
+	Subsystem->AddMappingContext(Refs.AppliedContext.Get(), Priority, Options);
+	if (bFirstReference)
+	{
+		INC_DWORD_STAT(STAT_InputSettings_LiveMappingContexts);
+	}
+	return true;
+}
+
+bool UInputMappingContextRegistry::RemoveMappingContext(const UInputMappingContext* MappingContext, const int32 Priority,
+                                                        const FModifyContextOptions& Options)
+{
+	if (!IsValid(MappingContext)) { return false; }
+
+	FContextRefs* const Refs = Contexts.Find(MappingContext);
+	const int32 PriorityIndex = Refs != nullptr
+		                            ? Refs->Priorities.IndexOfByPredicate([Priority](const FPriorityRefs& PriorityRefs) { return PriorityRefs.Priority == Priority; })
+		                            : INDEX_NONE;
+	if (PriorityIndex == INDEX_NONE)
+	{
+		UE_LOG(LogInputSettings, Verbose, TEXT("%s: %s was not added with priority %d, ignored."), *FString(__FUNCTION__),
+		       *MappingContext->GetName(), Priority);
+		return false;
+	}
+
+	if (--Refs->Priorities[PriorityIndex].Count == 0)
+	{
+		Refs->Priorities.RemoveAt(PriorityIndex);
+	}
+
+	UEnhancedInputLocalPlayerSubsystem* const Subsystem = GetInputSubsystem();
+	const UInputMappingContext* const AppliedContext = Refs->AppliedContext.Get();
+	if (Refs->Priorities.IsEmpty())
+	{
+		Contexts.Remove(MappingContext);
+		if (!IsValid(Subsystem)) { return false; }
+
+		Subsystem->RemoveMappingContext(AppliedContext, Options);
+		DEC_DWORD_STAT(STAT_InputSettings_LiveMappingContexts);
+		return true;
+	}
+
+	// still referenced at the applied priority
+	const int32 HighestPriority = Refs->Priorities[0].Priority;
+	if (HighestPriority == Refs->AppliedPriority || !IsValid(Subsystem))
+	{
+		InputMappingContextRegistry::CountAvoidedRebuild();
+		return false;
+	}
+
+	// the highest reference went away, fall back to the next one
+	Refs->AppliedPriority = HighestPriority;
+	Subsystem->AddMappingContext(AppliedContext, HighestPriority, Options);
+	return true;
+}
+
+const UInputMappingContext* UInputMappingContextRegistry::GetAppliedContext(const UInputMappingContext* MappingContext) const
+{
+	const FContextRefs* const Refs = Contexts.Find(MappingContext);
+	return Refs != nullptr ? Refs->AppliedContext.Get() : nullptr;
+}
+
+void UInputMappingContextRegistry::GetMappingContexts(TArray<const UInputMappingContext*>& OutMappingContexts) const
+{
+	OutMappingContexts.Reserve(OutMappingContexts.Num() + Contexts.Num());
+	for (const TPair<TObjectKey<UInputMappingContext>, FContextRefs>& Pair : Contexts)
+	{
+		if (const UInputMappingContext* const MappingContext = Pair.Key.ResolveObjectPtr())
+		{
+			OutMappingContexts.Add(MappingContext);
+		}
+	}
+}
+
+bool UInputMappingContextRegistry::RefreshMappingContext(const UInputMappingContext* MappingContext, const FModifyContextOptions& Options)
+{
+	FContextRefs* const Refs = Contexts.Find(MappingContext);
+	if (Refs == nullptr) { return false; }
+
+	const UInputMappingContext* const EffectiveContext = GetEffectiveContext(MappingContext);
+	const UInputMappingContext* const AppliedContext = Refs->AppliedContext.Get();
+	if (EffectiveContext == AppliedContext) { return false; }
+
+	UEnhancedInputLocalPlayerSubsystem* const Subsystem = GetInputSubsystem();
+	if (!IsValid(Subsystem)) { return false; }
+
+	// same priority, only this context's mappings differ
+	if (IsValid(AppliedContext))
+	{
+		Subsystem->RemoveMappingContext(AppliedContext, Options);
+	}
+	Subsystem->AddMappingContext(EffectiveContext, Refs->AppliedPriority, Options);
+	Refs->AppliedContext = EffectiveContext;
+	return true;
+}
+
+int32 UInputMappingContextRegistry::GetRefCount(const UInputMappingContext* MappingContext) const
+{
+	const FContextRefs* const Refs = Contexts.Find(MappingContext);
+	if (Refs == nullptr) { return 0; }
+
+	int32 RefCount = 0;
+	for (const FPriorityRefs& PriorityRefs : Refs->Priorities)
+	{
+		RefCount += PriorityRefs.Count;
+	}
+	return RefCount;
+}
+
+int32 UInputMappingContextRegistry::GetNumAvoidedRebuilds()
+{
+	return InputMappingContextRegistry::NumAvoidedRebuilds;
+}
+
+void UInputMappingContextRegistry::BeginMappingContextBatch(FInputMappingContextBatch& MappingBatch)
+{
+	ensureMsgf(!MappingBatch.bOpen, TEXT("%s: Mapping context batch is already open."), *FString(__FUNCTION__));
+
+	MappingBatch.Operations.Reset();
+	MappingBatch.bOpen = true;
+}
+
+void UInputMappingContextRegistry::BatchAddMappingContext(FInputMappingContextBatch& MappingBatch, UEnhancedInputLocalPlayerSubsystem* Subsystem,
+                                                          const UInputMappingContext* MappingContext, const int32 Priority)
+{
+	if (!ensure(MappingBatch.bOpen) || !IsValid(Subsystem) || !IsValid(MappingContext)) { return; }
+
+	MappingBatch.Operations.Add({Subsystem, MappingContext, Priority, true});
+}
+
+void UInputMappingContextRegistry::BatchRemoveMappingContext(FInputMappingContextBatch& MappingBatch, UEnhancedInputLocalPlayerSubsystem* Subsystem,
+                                                             const UInputMappingContext* MappingContext, const int32 Priority)
+{
+	if (!ensure(MappingBatch.bOpen) || !IsValid(Subsystem) || !IsValid(MappingContext)) { return; }
+
+	MappingBatch.Operations.Add({Subsystem, MappingContext, Priority, false});
+}
+
+int32 UInputMappingContextRegistry::CommitMappingContextBatch(FInputMappingContextBatch& MappingBatch)
+{
+	if (!ensure(MappingBatch.bOpen)) { return 0; }
+	MappingBatch.bOpen = false;
+
+	// every change only flags the mappings as dirty...
+	FModifyContextOptions DeferredOptions;
+	DeferredOptions.bForceImmediately = false;
+
+	TArray<UEnhancedInputLocalPlayerSubsystem*, TInlineAllocator<4>> DirtySubsystems;
+	for (const auto& [WeakSubsystem, WeakMappingContext, Priority, bAdd] : MappingBatch.Operations)
+	{
+		UEnhancedInputLocalPlayerSubsystem* const Subsystem = WeakSubsystem.Get();
+		const UInputMappingContext* const MappingContext = WeakMappingContext.Get();
+		if (!IsValid(Subsystem) || !IsValid(MappingContext)) { continue; }
+
+		UInputMappingContextRegistry* const Registry = Get(Subsystem);
+		if (!ensure(IsValid(Registry))) { continue; }
+
+		// a context another holder still references leaves the subsystem untouched, no rebuild for it
+		if (bAdd ? Registry->AddMappingContext(MappingContext, Priority, DeferredOptions)
+		         : Registry->RemoveMappingContext(MappingContext, Priority, DeferredOptions))
+		{
+			DirtySubsystems.AddUnique(Subsystem);
+		}
+	}
+	MappingBatch.Operations.Reset();
+
+	// ...and each touched player rebuilds its control mappings exactly once
+	FModifyContextOptions RebuildOptions;
+	RebuildOptions.bForceImmediately = true;
+	for (UEnhancedInputLocalPlayerSubsystem* const Subsystem : DirtySubsystems)
+	{
+		Subsystem->RequestRebuildControlMappings(RebuildOptions);
+	}
+
+	InputMappingContextRegistry::NumMappingRebuildRequests += DirtySubsystems.Num();
+	return DirtySubsystems.Num();
+}
+
+int32 UInputMappingContextRegistry::GetNumMappingRebuildRequests()
+{
+	return InputMappingContextRegistry::NumMappingRebuildRequests;
+}
+
+UEnhancedInputLocalPlayerSubsystem* UInputMappingContextRegistry::GetInputSubsystem() const
+{
+	return ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer());
+}
+
+const UInputMappingContext* UInputMappingContextRegistry::GetEffectiveContext(const UInputMappingContext* MappingContext) const
+{
+	UInputKeyRemapSubsystem* const KeyRemap = ULocalPlayer::GetSubsystem<UInputKeyRemapSubsystem>(GetLocalPlayer());
+	return IsValid(KeyRemap) ? KeyRemap->GetRemappedContext(MappingContext) : MappingContext;
+}
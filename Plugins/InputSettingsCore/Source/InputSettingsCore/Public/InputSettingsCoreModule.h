@@ -0,0 +1,29 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Modules/ModuleManager.h"
+#include "Trace/Trace.h"
+
+// per-binding diagnostics are Verbose, shipping compiles everything below Warning out
+#if UE_BUILD_SHIPPING
+INPUTSETTINGSCORE_API DECLARE_LOG_CATEGORY_EXTERN(LogInputSettings, Log, Warning);
+#else
+INPUTSETTINGSCORE_API DECLARE_LOG_CATEGORY_EXTERN(LogInputSettings, Log, All);
+#endif
+
+// enable with -trace=default,InputSettings
+UE_TRACE_CHANNEL_EXTERN(InputSettingsChannel, INPUTSETTINGSCORE_API);
+
+/*
+ * Input code the game module uses directly, kept out of the InputSettings game feature so the feature can be toggled and unloaded.
+ */
+class FInputSettingsCoreModule : public IModuleInterface
+{
+public:
+	//~IModuleInterface
+	virtual void StartupModule() override;
+	virtual void ShutdownModule() override;
+	//~End of IModuleInterface
+};
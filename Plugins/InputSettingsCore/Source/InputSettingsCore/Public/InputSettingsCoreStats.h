@@ -0,0 +1,10 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "InputSettingsCoreModule.h"
+#include "Stats/Stats.h"
+
+DECLARE_STATS_GROUP(TEXT("InputSettings"), STATGROUP_InputSettings, STATCAT_Advanced);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Mapping Contexts"), STAT_InputSettings_LiveMappingContexts, STATGROUP_InputSettings, INPUTSETTINGSCORE_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Avoided Mapping Rebuilds"), STAT_InputSettings_AvoidedMappingRebuilds, STATGROUP_InputSettings, INPUTSETTINGSCORE_API);
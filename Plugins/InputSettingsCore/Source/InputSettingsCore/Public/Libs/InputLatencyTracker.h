@@ -0,0 +1,147 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+
+class FAutoConsoleVariableRef;
+
+// the stamps compile to an inlined false check in shipping
+#define INPUTSETTINGS_WITH_LATENCY_TRACKING !UE_BUILD_SHIPPING
+
+/* How the handler of an input event was reached */
+enum class EInputLatencySource : uint8
+{
+	/* Data-driven binding dispatched through its dynamic delegate */
+	Reflected,
+	/* Member function delegate, from SetupPlayerInputComponent or a registered native binder */
+	Native,
+
+	Num
+};
+
+/* Stage boundaries of an input event, from the frame pumping the device messages to the movement component update */
+enum class EInputLatencyStage : uint8
+{
+	/* Frame start to the player controller processing input, the device messages are pumped in between */
+	Pump,
+	/* Input processing to the handler being called, Enhanced Input evaluation and binding dispatch */
+	Dispatch,
+	/* Handler to AddMovementInput, includes aggregation delays */
+	Handler,
+	/* AddMovementInput to the end of the character movement update */
+	Movement,
+	/* Frame start to the end of the movement update */
+	Total,
+
+	Num
+};
+
+/*
+ * Stamps input events from the frame start to the movement update that consumed them.
+ * Every completed event adds one sample per stage, the p50/p99 of the frame are exported on the InputSettings trace channel
+ * and as the InputLatency CSV category, the whole session is kept in a fixed bucket histogram.
+ * Enable with InputSettings.Latency.Enable 1, events without a movement update (look, jump) are dropped at the end of the frame.
+ */
+class INPUTSETTINGSCORE_API FInputLatencyTracker
+{
+public:
+	static FInputLatencyTracker& Get();
+	static void TearDown();
+
+	static bool IsEnabled()
+	{
+#if INPUTSETTINGS_WITH_LATENCY_TRACKING
+		return bEnabled;
+#else
+		return false;
+#endif
+	}
+
+	/* The player controller starts processing input for the frame */
+	void MarkInputProcessing();
+
+	/* A handler was reached, nested marks of the same event (a reflected binding calling a native handler) are ignored */
+	void BeginDispatch(const EInputLatencySource Source);
+	void EndDispatch();
+
+	/*
+	 * Movement input was added. Inside a dispatch only the event being dispatched is stamped,
+	 * outside of one (an aggregated flush) every event that deferred its movement input is.
+	 */
+	void MarkMovementInput();
+
+	/* The event being dispatched will add its movement input later, from an aggregated flush */
+	void MarkMovementInputDeferred();
+
+	/* The character movement update consumed the movement input */
+	void MarkMovementUpdate();
+
+	/* Session percentile in milliseconds, from the bucket histogram */
+	float GetSessionPercentileMs(const EInputLatencySource Source, const EInputLatencyStage Stage, const float Percentile) const;
+	int32 GetSessionNumSamples(const EInputLatencySource Source) const;
+	void ResetSession();
+
+	/* Log the session p50/p99 of every source and stage */
+	void LogSessionReport() const;
+
+	/* Brackets a handler with BeginDispatch/EndDispatch when tracking is enabled */
+	struct FDispatchScope
+	{
+		explicit FDispatchScope(const EInputLatencySource Source)
+			: bActive(IsEnabled())
+		{
+			if (bActive) { Get().BeginDispatch(Source); }
+		}
+
+		~FDispatchScope()
+		{
+			if (bActive) { Get().EndDispatch(); }
+		}
+
+	private:
+		bool bActive;
+	};
+
+private:
+	FInputLatencyTracker();
+	~FInputLatencyTracker();
+
+	void HandleBeginFrame();
+	void HandleEndFrame();
+
+	struct FEventStamps
+	{
+		uint64 DispatchCycles = 0;
+		uint64 MovementInputCycles = 0;
+		EInputLatencySource Source = EInputLatencySource::Native;
+		bool bMovementInputDeferred = false;
+		bool bCompleted = false;
+	};
+
+	// 50us buckets up to 100ms, the last one collects everything above
+	static constexpr int32 NumBuckets = 2001;
+	static constexpr double BucketMs = 0.05;
+
+	struct FStageHistogram
+	{
+		TArray<uint32> Buckets;
+		uint32 NumSamples = 0;
+	};
+
+	// InputSettings.Latency.Enable
+	static bool bEnabled;
+	static FAutoConsoleVariableRef EnableCVar;
+
+	uint64 FrameStartCycles = 0;
+	uint64 InputProcessingCycles = 0;
+	int32 DispatchDepth = 0;
+	TArray<FEventStamps> FrameEvents;
+	// event of the outermost open dispatch, nested dispatches belong to it
+	int32 OpenEventIndex = INDEX_NONE;
+
+	// samples of the current frame in milliseconds, per source and stage
+	TArray<float> FrameSamples[static_cast<int32>(EInputLatencySource::Num)][static_cast<int32>(EInputLatencyStage::Num)];
+	FStageHistogram SessionHistograms[static_cast<int32>(EInputLatencySource::Num)][static_cast<int32>(EInputLatencyStage::Num)];
+
+	FDelegateHandle BeginFrameHandle;
+	FDelegateHandle EndFrameHandle;
+};
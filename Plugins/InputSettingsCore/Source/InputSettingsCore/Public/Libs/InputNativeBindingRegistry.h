@@ -0,0 +1,74 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "EnhancedInputComponent.h"
+#include "HAL/CriticalSection.h"
+
+class UInputAction;
+
+/* Binds one native member function on the input component, the resulting dispatch is the same as a hand written BindAction */
+using FInputNativeBinder = TFunction<FInputBindingHandle(UEnhancedInputComponent&, const UInputAction*, ETriggerEvent, UObject*)>;
+
+/*
+ * Opt-in table of native input handlers addressable by name from FFunctionStackedData.
+ * Register from C++ (module startup or the CDO constructor), bindings resolved to a registered function skip the dynamic delegate.
+ * Only native classes can register, the table holds raw class pointers.
+ */
+class INPUTSETTINGSCORE_API FInputNativeBindingRegistry
+{
+public:
+	static FInputNativeBindingRegistry& Get();
+	static void TearDown();
+
+	template <typename UserClass>
+	void Register(const FName FunctionName, void (UserClass::*Func)())
+	{
+		RegisterBinder(UserClass::StaticClass(), FunctionName,
+			[Func](UEnhancedInputComponent& InputComponent, const UInputAction* InputAction, const ETriggerEvent Trigger, UObject* Owner)
+			{
+				return FInputBindingHandle(InputComponent.BindAction(InputAction, Trigger, CastChecked<UserClass>(Owner), Func));
+			});
+	}
+
+	template <typename UserClass>
+	void Register(const FName FunctionName, void (UserClass::*Func)(const FInputActionValue&))
+	{
+		RegisterBinder(UserClass::StaticClass(), FunctionName,
+			[Func](UEnhancedInputComponent& InputComponent, const UInputAction* InputAction, const ETriggerEvent Trigger, UObject* Owner)
+			{
+				return FInputBindingHandle(InputComponent.BindAction(InputAction, Trigger, CastChecked<UserClass>(Owner), Func));
+			});
+	}
+
+	template <typename UserClass>
+	void Register(const FName FunctionName, void (UserClass::*Func)(const FInputActionInstance&))
+	{
+		RegisterBinder(UserClass::StaticClass(), FunctionName,
+			[Func](UEnhancedInputComponent& InputComponent, const UInputAction* InputAction, const ETriggerEvent Trigger, UObject* Owner)
+			{
+				return FInputBindingHandle(InputComponent.BindAction(InputAction, Trigger, CastChecked<UserClass>(Owner), Func));
+			});
+	}
+
+	void Unregister(const UClass* OwnerClass, const FName FunctionName);
+
+	/* Binder registered for the function on the class itself or on its closest registered super class */
+	TSharedPtr<const FInputNativeBinder> Find(const UClass* OwnerClass, const FName FunctionName) const;
+
+	/* Broadcast on the game thread after every (un)registration, whatever resolved binders before must resolve them again */
+	FSimpleMulticastDelegate OnBindersChanged;
+
+private:
+	void RegisterBinder(const UClass* OwnerClass, const FName FunctionName, FInputNativeBinder&& Binder);
+
+	struct FRegisteredBinder
+	{
+		const UClass* OwnerClass = nullptr;
+		TSharedRef<const FInputNativeBinder> Binder;
+	};
+
+	// few classes register the same name, a short linear scan per name is enough
+	TMap<FName, TArray<FRegisteredBinder, TInlineAllocator<1>>> Binders;
+	// plans are also compiled on worker threads, registration stays on the game thread
+	mutable FRWLock BindersLock;
+};
@@ -0,0 +1,106 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "InputCoreTypes.h"
+#include "Subsystems/LocalPlayerSubsystem.h"
+#include "Tasks/Task.h"
+#include "InputKeyRemapSubsystem.generated.h"
+
+class UInputAction;
+class UInputMappingContext;
+
+/* A player's replacement for one default key of an input action, applied to every mapping context mapping the action to that key */
+USTRUCT(BlueprintType, Category = "Extra Actions | Modular Structs")
+struct FInputKeyOverride
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
+	TSoftObjectPtr<UInputAction> Action;
+
+	/* Key the mapping context maps the action to */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
+	FKey DefaultKey;
+
+	/* Key the player picked instead */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Settings")
+	FKey Key;
+};
+
+/*
+ * Player mappable keys on top of the contexts applied through UInputMappingContextRegistry.
+ * A context mapping an overridden key is replaced by a transient remapped copy, a remap only swaps the copies of the contexts
+ * mapping that key. Overrides persist per platform user in a small binary blob, loaded off the game thread when the player logs in.
+ */
+UCLASS()
+class INPUTSETTINGSCORE_API UInputKeyRemapSubsystem : public ULocalPlayerSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/* Map the action to Key wherever a context maps it to DefaultKey, returns false when nothing changed */
+	UFUNCTION(BlueprintCallable, Category = "Input|Key Remapping")
+	bool RemapKey(const UInputAction* Action, const FKey DefaultKey, const FKey Key);
+
+	/* Back to DefaultKey, returns false when the key was not overridden */
+	UFUNCTION(BlueprintCallable, Category = "Input|Key Remapping")
+	bool ResetKey(const UInputAction* Action, const FKey DefaultKey);
+
+	UFUNCTION(BlueprintCallable, Category = "Input|Key Remapping")
+	void ResetAllKeys();
+
+	/* Key the action is mapped to in place of DefaultKey */
+	UFUNCTION(BlueprintPure, Category = "Input|Key Remapping")
+	FKey GetMappedKey(const UInputAction* Action, const FKey DefaultKey) const;
+
+	UFUNCTION(BlueprintPure, Category = "Input|Key Remapping")
+	TArray<FInputKeyOverride> GetKeyOverrides() const;
+
+	/* True until the saved overrides of the player were read and applied */
+	UFUNCTION(BlueprintPure, Category = "Input|Key Remapping")
+	bool IsLoadingKeyOverrides() const { return bLoadingOverrides; }
+
+	/* The context with the player's overrides applied, the context itself when none of them concerns it */
+	const UInputMappingContext* GetRemappedContext(const UInputMappingContext* MappingContext);
+
+	/* Compact versioned blob, a header and three strings per override */
+	static void SerializeOverrides(const TArray<FInputKeyOverride>& Overrides, TArray<uint8>& OutBlob);
+	static bool DeserializeOverrides(TConstArrayView<uint8> Blob, TArray<FInputKeyOverride>& OutOverrides);
+
+private:
+	struct FOverrideKey
+	{
+		FSoftObjectPath Action;
+		FKey DefaultKey;
+
+		bool operator==(const FOverrideKey& Other) const { return Action == Other.Action && DefaultKey == Other.DefaultKey; }
+		friend uint32 GetTypeHash(const FOverrideKey& Key) { return HashCombine(GetTypeHash(Key.Action), GetTypeHash(Key.DefaultKey)); }
+	};
+
+	static bool DoesContextMapKey(const UInputMappingContext* MappingContext, const FSoftObjectPath& Action, const FKey& DefaultKey);
+	UInputMappingContext* CreateRemappedContext(const UInputMappingContext* MappingContext) const;
+
+	/* Drop the remapped copies concerned by the change and swap the live contexts, the control mappings are rebuilt once */
+	void ApplyOverrideChanges(TConstArrayView<FOverrideKey> ChangedKeys);
+
+	void LoadOverrides();
+	void HandleOverridesLoaded(TArray<FInputKeyOverride>&& LoadedOverrides);
+	void SaveOverrides();
+	FString GetSaveFilePath() const;
+
+	TMap<FOverrideKey, FKey> KeyOverrides;
+
+	// remapped copy of every referenced context concerned by an override
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<const UInputMappingContext>, TObjectPtr<UInputMappingContext>> RemappedContexts;
+
+	// contexts already checked and left alone by every override
+	TSet<TObjectKey<UInputMappingContext>> UnaffectedContexts;
+
+	// writes are chained, the file always ends up with the latest blob
+	UE::Tasks::FTask SaveTask;
+	bool bLoadingOverrides = false;
+};
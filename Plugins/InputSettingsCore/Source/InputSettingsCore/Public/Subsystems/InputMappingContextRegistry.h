@@ -0,0 +1,99 @@
+﻿#pragma once
+
+#include "CoreMinimal.h"
+#include "EnhancedInputSubsystemInterface.h"
+#include "Subsystems/LocalPlayerSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "InputMappingContextRegistry.generated.h"
+
+class UInputMappingContext;
+class UEnhancedInputLocalPlayerSubsystem;
+
+/* Mapping context changes collected by UInputMappingContextRegistry and committed with one control mapping rebuild per player */
+struct FInputMappingContextBatch
+{
+	struct FOperation
+	{
+		TWeakObjectPtr<UEnhancedInputLocalPlayerSubsystem> Subsystem;
+		TWeakObjectPtr<const UInputMappingContext> MappingContext;
+		int32 Priority = 0;
+		bool bAdd = true;
+	};
+
+	TArray<FOperation> Operations;
+	bool bOpen = false;
+};
+/*
+ * Reference counts the mapping contexts a local player was asked to apply, per priority.
+ * The enhanced input subsystem is only touched when a context gains its first or loses its last reference,
+ * or when the highest requested priority changes, so features sharing a context don't rebuild or remove it for each other.
+ */
+UCLASS()
+class INPUTSETTINGSCORE_API UInputMappingContextRegistry : public ULocalPlayerSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static UInputMappingContextRegistry* Get(const UEnhancedInputLocalPlayerSubsystem* Subsystem);
+
+	/* Add a reference, returns true when the subsystem was changed and its control mappings need a rebuild */
+	bool AddMappingContext(const UInputMappingContext* MappingContext, const int32 Priority,
+	                       const FModifyContextOptions& Options = FModifyContextOptions());
+
+	/* Release a reference taken with the same priority, returns true when the subsystem was changed */
+	bool RemoveMappingContext(const UInputMappingContext* MappingContext, const int32 Priority,
+	                          const FModifyContextOptions& Options = FModifyContextOptions());
+
+	int32 GetRefCount(const UInputMappingContext* MappingContext) const;
+
+	/* Context handed to the subsystem for a referenced context, its key remapped copy when the player has overrides for it */
+	const UInputMappingContext* GetAppliedContext(const UInputMappingContext* MappingContext) const;
+
+	/* Every context currently referenced, as requested (before key remapping) */
+	void GetMappingContexts(TArray<const UInputMappingContext*>& OutMappingContexts) const;
+
+	/* Swap a referenced context for its current remapped version, returns true when the subsystem was changed */
+	bool RefreshMappingContext(const UInputMappingContext* MappingContext, const FModifyContextOptions& Options = FModifyContextOptions());
+
+	/* Adds and removes absorbed by an existing reference since startup, each one a control mapping rebuild saved */
+	static int32 GetNumAvoidedRebuilds();
+
+	/* Start collecting mapping context changes, nothing reaches the subsystems until the batch is committed */
+	static void BeginMappingContextBatch(FInputMappingContextBatch& MappingBatch);
+
+	static void BatchAddMappingContext(FInputMappingContextBatch& MappingBatch, UEnhancedInputLocalPlayerSubsystem* Subsystem,
+	                                   const UInputMappingContext* MappingContext, const int32 Priority);
+
+	static void BatchRemoveMappingContext(FInputMappingContextBatch& MappingBatch, UEnhancedInputLocalPlayerSubsystem* Subsystem,
+	                                      const UInputMappingContext* MappingContext, const int32 Priority);
+
+	/*
+	 * Apply every batched change through the players' registries with a single control mapping rebuild per subsystem, returns the number of rebuilds.
+	 * A subsystem only rebuilds when a context was really added or removed.
+	 */
+	static int32 CommitMappingContextBatch(FInputMappingContextBatch& MappingBatch);
+
+	/* Control mapping rebuilds requested through committed batches since startup */
+	static int32 GetNumMappingRebuildRequests();
+
+private:
+	struct FPriorityRefs
+	{
+		int32 Priority = 0;
+		int32 Count = 0;
+	};
+
+	struct FContextRefs
+	{
+		// sorted by descending priority, the first one is applied to the subsystem
+		TArray<FPriorityRefs, TInlineAllocator<2>> Priorities;
+		int32 AppliedPriority = 0;
+		// the context itself or its key remapped copy
+		TWeakObjectPtr<const UInputMappingContext> AppliedContext;
+	};
+
+	UEnhancedInputLocalPlayerSubsystem* GetInputSubsystem() const;
+	const UInputMappingContext* GetEffectiveContext(const UInputMappingContext* MappingContext) const;
+
+	TMap<TObjectKey<UInputMappingContext>, FContextRefs> Contexts;
+};
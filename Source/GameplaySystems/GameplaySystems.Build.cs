@@ -23,7 +23,9 @@ public class GameplaySystems : ModuleRules
 			"ModularGameplay"
 		});
 
-		PrivateDependencyModuleNames.AddRange(new string[] { });
+		PrivateDependencyModuleNames.AddRange(new string[] {
+			"InputSettingsCore"
+		});
 
 		PublicIncludePaths.AddRange(new string[] {
 			"GameplaySystems"
@@ -1,8 +1,23 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "GameplaySystems.h"
+#include "GameplaySystemsCharacter.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, GameplaySystems, "GameplaySystems" );
+class FGameplaySystemsModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		AGameplaySystemsCharacter::RegisterNativeInputBinders();
+	}
+
+	virtual void ShutdownModule() override
+	{
+		AGameplaySystemsCharacter::UnregisterNativeInputBinders();
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FGameplaySystemsModule, GameplaySystems, "GameplaySystems" );
 
 DEFINE_LOG_CATEGORY(LogGameplaySystems)
\ No newline at end of file
@@ -11,6 +11,9 @@
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
 #include "GameplaySystems.h"
+#include "GameplaySystemsInputRecorder.h"
+#include "Libs/InputLatencyTracker.h"
+#include "Libs/InputNativeBindingRegistry.h"
 
 AGameplaySystemsCharacter::AGameplaySystemsCharacter()
 {
@@ -50,14 +53,63 @@ AGameplaySystemsCharacter::AGameplaySystemsCharacter()
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
 }
 
+void AGameplaySystemsCharacter::RegisterNativeInputBinders()
+{
+	// Let data driven input settings bind the per frame handlers natively instead of through ProcessEvent
+	FInputNativeBindingRegistry& NativeBindings = FInputNativeBindingRegistry::Get();
+	NativeBindings.Register(GET_FUNCTION_NAME_CHECKED(AGameplaySystemsCharacter, Move), &AGameplaySystemsCharacter::Move);
+	NativeBindings.Register(GET_FUNCTION_NAME_CHECKED(AGameplaySystemsCharacter, Look), &AGameplaySystemsCharacter::Look);
+	NativeBindings.Register(GET_FUNCTION_NAME_CHECKED(AGameplaySystemsCharacter, DoJumpStart), &AGameplaySystemsCharacter::DoJumpStart);
+	NativeBindings.Register(GET_FUNCTION_NAME_CHECKED(AGameplaySystemsCharacter, DoJumpEnd), &AGameplaySystemsCharacter::DoJumpEnd);
+}
+
+void AGameplaySystemsCharacter::UnregisterNativeInputBinders()
+{
+	FInputNativeBindingRegistry& NativeBindings = FInputNativeBindingRegistry::Get();
+	NativeBindings.Unregister(StaticClass(), GET_FUNCTION_NAME_CHECKED(AGameplaySystemsCharacter, Move));
+	NativeBindings.Unregister(StaticClass(), GET_FUNCTION_NAME_CHECKED(AGameplaySystemsCharacter, Look));
+	NativeBindings.Unregister(StaticClass(), GET_FUNCTION_NAME_CHECKED(AGameplaySystemsCharacter, DoJumpStart));
+	NativeBindings.Unregister(StaticClass(), GET_FUNCTION_NAME_CHECKED(AGameplaySystemsCharacter, DoJumpEnd));
+}
+
+void AGameplaySystemsCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// cache the recorder, the input handlers run every frame
+	InputRecorder = GetWorld()->GetSubsystem<UGameplaySystemsInputRecorder>();
+
+	// last stage of the input latency samples, broadcast at the end of the movement update
+	OnCharacterMovementUpdated.AddDynamic(this, &AGameplaySystemsCharacter::HandleMovementUpdated);
+}
+
+void AGameplaySystemsCharacter::HandleMovementUpdated(float DeltaSeconds, FVector OldLocation, FVector OldVelocity)
+{
+	if (FInputLatencyTracker::IsEnabled() && IsLocallyControlled())
+	{
+		FInputLatencyTracker::Get().MarkMovementUpdate();
+	}
+}
+
+void AGameplaySystemsCharacter::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	// in latency preserving mode the controller already flushed, this only catches input that arrived after it
+	if (InputAggregation != EGameplaySystemsInputAggregation::Disabled)
+	{
+		FlushAggregatedInput();
+	}
+}
+
 void AGameplaySystemsCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
 {
 	// Set up action bindings
 	if (UEnhancedInputComponent* EnhancedInputComponent = Cast<UEnhancedInputComponent>(PlayerInputComponent)) {
 		
 		// Jumping
-		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Started, this, &ACharacter::Jump);
-		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Completed, this, &ACharacter::StopJumping);
+		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Started, this, &AGameplaySystemsCharacter::DoJumpStart);
+		EnhancedInputComponent->BindAction(JumpAction, ETriggerEvent::Completed, this, &AGameplaySystemsCharacter::DoJumpEnd);
 
 		// Moving
 		EnhancedInputComponent->BindAction(MoveAction, ETriggerEvent::Triggered, this, &AGameplaySystemsCharacter::Move);
@@ -74,9 +126,30 @@ void AGameplaySystemsCharacter::SetupPlayerInputComponent(UInputComponent* Playe
 
 void AGameplaySystemsCharacter::Move(const FInputActionValue& Value)
 {
+	// data-driven bindings dispatched through their dynamic delegate already opened the sample
+	const FInputLatencyTracker::FDispatchScope LatencyScope(EInputLatencySource::Native);
+
 	// input is a Vector2D
 	FVector2D MovementVector = Value.Get<FVector2D>();
 
+	if (InputRecorder && InputRecorder->IsRecording())
+	{
+		InputRecorder->RecordInput(EGameplaySystemsInputChannel::Move, MovementVector);
+	}
+
+	// movement input is additive, the sum applied once gives the same result
+	if (InputAggregation != EGameplaySystemsInputAggregation::Disabled)
+	{
+		PendingMoveInput += MovementVector;
+		bHasPendingMoveInput = true;
+
+		if (FInputLatencyTracker::IsEnabled())
+		{
+			FInputLatencyTracker::Get().MarkMovementInputDeferred();
+		}
+		return;
+	}
+
 	// route the input
 	DoMove(MovementVector.X, MovementVector.Y);
 }
@@ -86,6 +159,19 @@ void AGameplaySystemsCharacter::Look(const FInputActionValue& Value)
 	// input is a Vector2D
 	FVector2D LookAxisVector = Value.Get<FVector2D>();
 
+	if (InputRecorder && InputRecorder->IsRecording())
+	{
+		InputRecorder->RecordInput(EGameplaySystemsInputChannel::Look, LookAxisVector);
+	}
+
+	// rotation input is additive as well, high polling mice would otherwise call into the controller per sample
+	if (InputAggregation != EGameplaySystemsInputAggregation::Disabled)
+	{
+		PendingLookInput += LookAxisVector;
+		bHasPendingLookInput = true;
+		return;
+	}
+
 	// route the input
 	DoLook(LookAxisVector.X, LookAxisVector.Y);
 }
@@ -97,16 +183,22 @@ void AGameplaySystemsCharacter::DoMove(float Right, float Forward)
 		// find out which way is forward
 		const FRotator Rotation = GetController()->GetControlRotation();
 		const FRotator YawRotation(0, Rotation.Yaw, 0);
+		const FRotationMatrix YawMatrix(YawRotation);
 
 		// get forward vector
-		const FVector ForwardDirection = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::X);
+		const FVector ForwardDirection = YawMatrix.GetUnitAxis(EAxis::X);
 
 		// get right vector 
-		const FVector RightDirection = FRotationMatrix(YawRotation).GetUnitAxis(EAxis::Y);
+		const FVector RightDirection = YawMatrix.GetUnitAxis(EAxis::Y);
 
 		// add movement 
 		AddMovementInput(ForwardDirection, Forward);
 		AddMovementInput(RightDirection, Right);
+
+		if (FInputLatencyTracker::IsEnabled())
+		{
+			FInputLatencyTracker::Get().MarkMovementInput();
+		}
 	}
 }
 
@@ -122,12 +214,59 @@ void AGameplaySystemsCharacter::DoLook(float Yaw, float Pitch)
 
 void AGameplaySystemsCharacter::DoJumpStart()
 {
+	if (InputRecorder && InputRecorder->IsRecording())
+	{
+		InputRecorder->RecordInput(EGameplaySystemsInputChannel::JumpStart);
+	}
+
 	// signal the character to jump
 	Jump();
 }
 
 void AGameplaySystemsCharacter::DoJumpEnd()
 {
+	if (InputRecorder && InputRecorder->IsRecording())
+	{
+		InputRecorder->RecordInput(EGameplaySystemsInputChannel::JumpEnd);
+	}
+
 	// signal the character to stop jumping
 	StopJumping();
 }
+
+void AGameplaySystemsCharacter::FlushAggregatedInput()
+{
+	// the control rotation basis is built once for the whole frame
+	if (bHasPendingMoveInput)
+	{
+		bHasPendingMoveInput = false;
+		DoMove(PendingMoveInput.X, PendingMoveInput.Y);
+		PendingMoveInput = FVector2D::ZeroVector;
+	}
+
+	if (bHasPendingLookInput)
+	{
+		bHasPendingLookInput = false;
+		DoLook(PendingLookInput.X, PendingLookInput.Y);
+		PendingLookInput = FVector2D::ZeroVector;
+	}
+}
+
+void AGameplaySystemsCharacter::ReplayInput(EGameplaySystemsInputChannel Channel, const FVector2D& Value)
+{
+	switch (Channel)
+	{
+	case EGameplaySystemsInputChannel::Move:
+		Move(FInputActionValue(Value));
+		break;
+	case EGameplaySystemsInputChannel::Look:
+		Look(FInputActionValue(Value));
+		break;
+	case EGameplaySystemsInputChannel::JumpStart:
+		DoJumpStart();
+		break;
+	case EGameplaySystemsInputChannel::JumpEnd:
+		DoJumpEnd();
+		break;
+	}
+}
@@ -10,10 +10,26 @@
 class USpringArmComponent;
 class UCameraComponent;
 class UInputAction;
+class UGameplaySystemsInputRecorder;
 struct FInputActionValue;
+enum class EGameplaySystemsInputChannel : uint8;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
 
+/** How move and look input reaching the character within a frame is applied */
+UENUM()
+enum class EGameplaySystemsInputAggregation : uint8
+{
+	/** Every input event is applied as it arrives */
+	Disabled,
+
+	/** Input is summed and applied once when the character ticks, may add up to a frame of latency */
+	EndOfFrame,
+
+	/** Input is summed and applied once by the player controller right after it processed input, same frame as unaggregated */
+	LatencyPreserving
+};
+
 /**
  *  A simple player-controllable third person character
  *  Implements a controllable orbiting camera
@@ -49,6 +65,23 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Input")
 	UInputAction* MouseLookAction;
 
+	/** Sums high rate move and look input (e.g. 1000+ Hz mice) and applies it once per frame */
+	UPROPERTY(EditAnywhere, Category="Input")
+	EGameplaySystemsInputAggregation InputAggregation = EGameplaySystemsInputAggregation::Disabled;
+
+	/** Move input summed since the last flush, X is right and Y is forward */
+	FVector2D PendingMoveInput = FVector2D::ZeroVector;
+
+	/** Look input summed since the last flush, X is yaw and Y is pitch */
+	FVector2D PendingLookInput = FVector2D::ZeroVector;
+
+	bool bHasPendingMoveInput = false;
+	bool bHasPendingLookInput = false;
+
+	/** Input recorder of the world, captures the input handlers below while recording */
+	UPROPERTY(Transient)
+	TObjectPtr<UGameplaySystemsInputRecorder> InputRecorder;
+
 public:
 
 	/** Constructor */
@@ -56,6 +89,16 @@ public:
 
 protected:
 
+	/** Gameplay initialization */
+	virtual void BeginPlay() override;
+
+	/** Applies aggregated input in EndOfFrame mode */
+	virtual void Tick(float DeltaSeconds) override;
+
+	/** Closes the input latency samples whose movement input this update consumed */
+	UFUNCTION()
+	void HandleMovementUpdated(float DeltaSeconds, FVector OldLocation, FVector OldVelocity);
+
 	/** Initialize input action bindings */
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
@@ -85,6 +128,21 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Input")
 	virtual void DoJumpEnd();
 
+	/** Registers the input handlers with the native binding registry, called once by the module on startup */
+	static void RegisterNativeInputBinders();
+
+	/** Removes the input handlers from the native binding registry, called by the module on shutdown */
+	static void UnregisterNativeInputBinders();
+
+	/** Applies the move and look input aggregated since the last flush */
+	void FlushAggregatedInput();
+
+	/** Returns the input aggregation mode */
+	EGameplaySystemsInputAggregation GetInputAggregation() const { return InputAggregation; }
+
+	/** Feeds a recorded input back into the matching input handler */
+	void ReplayInput(EGameplaySystemsInputChannel Channel, const FVector2D& Value);
+
 public:
 
 	/** Returns CameraBoom subobject **/
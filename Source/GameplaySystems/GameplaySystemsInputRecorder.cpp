@@ -0,0 +1,498 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "GameplaySystemsInputRecorder.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "GameplaySystems.h"
+#include "GameplaySystemsCharacter.h"
+
+namespace GameplaySystemsInputRecorder
+{
+	/** Frames never straddle chunks, a chunk is closed once it grows past this size */
+	constexpr int32 ChunkSize = 16 * 1024;
+
+	constexpr uint32 FileMagic = 0x52495347; // "GSIR"
+	constexpr int32 FileVersion = 1;
+
+	uint32 FloatToBits(const float Value)
+	{
+		uint32 Bits;
+		FMemory::Memcpy(&Bits, &Value, sizeof(Bits));
+		return Bits;
+	}
+
+	float BitsToFloat(const uint32 Bits)
+	{
+		float Value;
+		FMemory::Memcpy(&Value, &Bits, sizeof(Value));
+		return Value;
+	}
+
+	uint32 ZigZagEncode(const int32 Value)
+	{
+		return (static_cast<uint32>(Value) << 1) ^ static_cast<uint32>(Value >> 31);
+	}
+
+	int32 ZigZagDecode(const uint32 Value)
+	{
+		return static_cast<int32>(Value >> 1) ^ -static_cast<int32>(Value & 1);
+	}
+
+	void WriteVarUInt(TArray<uint8>& Bytes, uint32 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Bytes.Add(static_cast<uint8>(Value | 0x80));
+			Value >>= 7;
+		}
+		Bytes.Add(static_cast<uint8>(Value));
+	}
+
+	bool ReadVarUInt(const TArray<uint8>& Bytes, int32& Offset, uint32& OutValue)
+	{
+		OutValue = 0;
+		for (int32 Shift = 0; Shift < 35; Shift += 7)
+		{
+			if (!Bytes.IsValidIndex(Offset)) { return false; }
+
+			const uint8 Byte = Bytes[Offset++];
+			OutValue |= static_cast<uint32>(Byte & 0x7F) << Shift;
+			if ((Byte & 0x80) == 0) { return true; }
+		}
+		return false;
+	}
+
+	/** Unchanged values cost a single byte, small changes of the same sign and exponent a few more */
+	void WriteDelta(TArray<uint8>& Bytes, uint32& PreviousBits, const float Value)
+	{
+		const uint32 Bits = FloatToBits(Value);
+		WriteVarUInt(Bytes, ZigZagEncode(static_cast<int32>(Bits - PreviousBits)));
+		PreviousBits = Bits;
+	}
+
+	bool ReadDelta(const TArray<uint8>& Bytes, int32& Offset, uint32& PreviousBits, float& OutValue)
+	{
+		uint32 Encoded;
+		if (!ReadVarUInt(Bytes, Offset, Encoded)) { return false; }
+
+		PreviousBits += static_cast<uint32>(ZigZagDecode(Encoded));
+		OutValue = BitsToFloat(PreviousBits);
+		return true;
+	}
+
+	bool IsAxisChannel(const EGameplaySystemsInputChannel Channel)
+	{
+		return Channel == EGameplaySystemsInputChannel::Move || Channel == EGameplaySystemsInputChannel::Look;
+	}
+
+	FString ResolveRecordingPath(const FString& FilePath)
+	{
+		return FPaths::IsRelative(FilePath) ? FPaths::ProjectSavedDir() / TEXT("InputRecordings") / FilePath : FilePath;
+	}
+}
+
+bool UGameplaySystemsInputRecorder::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UGameplaySystemsInputRecorder::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UGameplaySystemsInputRecorder::HandleWorldTickStart);
+}
+
+void UGameplaySystemsInputRecorder::Deinitialize()
+{
+	FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+
+	StopReplay();
+
+	// command line recordings are written out when the world goes away
+	FString RecordFile;
+	if (bRecording && FParse::Value(FCommandLine::Get(), TEXT("InputRecordFile="), RecordFile))
+	{
+		StopRecording();
+		SaveRecording(RecordFile);
+	}
+
+	Super::Deinitialize();
+}
+
+void UGameplaySystemsInputRecorder::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// -InputReplay=<File> [-InputReplayExit] or -InputRecordFile=<File>
+	FString ReplayFile;
+	FString RecordFile;
+	if (FParse::Value(FCommandLine::Get(), TEXT("InputReplay="), ReplayFile))
+	{
+		StartReplay(ReplayFile);
+	}
+	else if (FParse::Value(FCommandLine::Get(), TEXT("InputRecordFile="), RecordFile))
+	{
+		StartRecording();
+	}
+}
+
+void UGameplaySystemsInputRecorder::StartRecording(const int32 CapacityBytes)
+{
+	StopReplay();
+
+	Chunks.Reset();
+	OldestChunk = 0;
+	NewestChunk = INDEX_NONE;
+	MaxChunks = FMath::Max(2, CapacityBytes / GameplaySystemsInputRecorder::ChunkSize);
+
+	PendingInputs.Reset();
+	bHasPendingFrame = false;
+	bRecording = true;
+}
+
+void UGameplaySystemsInputRecorder::StopRecording()
+{
+	if (!bRecording)
+	{
+		return;
+	}
+
+	// the frame in progress holds the input of the current tick
+	if (bHasPendingFrame)
+	{
+		CommitFrame();
+	}
+
+	bRecording = false;
+}
+
+bool UGameplaySystemsInputRecorder::SaveRecording(const FString& FilePath) const
+{
+	TArray<uint8> FileData;
+	FMemoryWriter Writer(FileData);
+
+	uint32 Magic = GameplaySystemsInputRecorder::FileMagic;
+	int32 Version = GameplaySystemsInputRecorder::FileVersion;
+	int32 NumChunks = Chunks.Num();
+	Writer << Magic << Version << NumChunks;
+
+	for (int32 Index = 0; Index < Chunks.Num(); ++Index)
+	{
+		FChunk Chunk = Chunks[(OldestChunk + Index) % Chunks.Num()];
+		Writer << Chunk.NumFrames << Chunk.Bytes;
+	}
+
+	const FString ResolvedPath = GameplaySystemsInputRecorder::ResolveRecordingPath(FilePath);
+	if (!FFileHelper::SaveArrayToFile(FileData, *ResolvedPath))
+	{
+		UE_LOG(LogGameplaySystems, Error, TEXT("Could not write input recording %s."), *ResolvedPath);
+		return false;
+	}
+
+	UE_LOG(LogGameplaySystems, Log, TEXT("Saved input recording %s (%d bytes)."), *ResolvedPath, FileData.Num());
+	return true;
+}
+
+bool UGameplaySystemsInputRecorder::StartReplay(const FString& FilePath)
+{
+	StopRecording();
+	StopReplay();
+
+	const FString ResolvedPath = GameplaySystemsInputRecorder::ResolveRecordingPath(FilePath);
+
+	TArray<uint8> FileData;
+	if (!FFileHelper::LoadFileToArray(FileData, *ResolvedPath))
+	{
+		UE_LOG(LogGameplaySystems, Error, TEXT("Could not read input recording %s."), *ResolvedPath);
+		return false;
+	}
+
+	FMemoryReader Reader(FileData);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	int32 NumChunks = 0;
+	Reader << Magic << Version << NumChunks;
+	if (Magic != GameplaySystemsInputRecorder::FileMagic || Version != GameplaySystemsInputRecorder::FileVersion || NumChunks < 0)
+	{
+		UE_LOG(LogGameplaySystems, Error, TEXT("%s is not a supported input recording."), *ResolvedPath);
+		return false;
+	}
+
+	Chunks.SetNum(NumChunks);
+	for (FChunk& Chunk : Chunks)
+	{
+		Reader << Chunk.NumFrames << Chunk.Bytes;
+	}
+	OldestChunk = 0;
+	NewestChunk = Chunks.Num() - 1;
+	MaxChunks = Chunks.Num();
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogGameplaySystems, Error, TEXT("Input recording %s is truncated."), *ResolvedPath);
+		Chunks.Reset();
+		return false;
+	}
+
+	ReadState.Reset();
+	ReadChunk = 0;
+	ReadOffset = 0;
+	ReadFrameInChunk = 0;
+
+	bHasNextFrame = ReadFrame(NextDeltaTime, NextInputs);
+	if (!bHasNextFrame)
+	{
+		UE_LOG(LogGameplaySystems, Error, TEXT("Input recording %s has no frames."), *ResolvedPath);
+		return false;
+	}
+
+	// every replayed frame advances by its recorded delta time, independently of the machine speed
+	bSavedUseFixedTimeStep = FApp::UseFixedTimeStep();
+	SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(NextDeltaTime);
+
+	NumReplayedFrames = 0;
+	ReplayStartTime = FPlatformTime::Seconds();
+	bReplaying = true;
+
+	return true;
+}
+
+void UGameplaySystemsInputRecorder::StopReplay()
+{
+	if (!bReplaying)
+	{
+		return;
+	}
+
+	FApp::SetUseFixedTimeStep(bSavedUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+
+	NextInputs.Reset();
+	bHasNextFrame = false;
+	bReplaying = false;
+}
+
+void UGameplaySystemsInputRecorder::RecordInput(const EGameplaySystemsInputChannel Channel, const FVector2D& Value)
+{
+	if (bRecording && bHasPendingFrame)
+	{
+		PendingInputs.Add({Channel, FVector2f(Value)});
+	}
+}
+
+void UGameplaySystemsInputRecorder::HandleWorldTickStart(UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds)
+{
+	if (TickedWorld != GetWorld())
+	{
+		return;
+	}
+
+	if (bRecording)
+	{
+		// input handled during a tick belongs to the delta time that tick started with
+		if (bHasPendingFrame)
+		{
+			CommitFrame();
+		}
+
+		PendingDeltaTime = DeltaSeconds;
+		bHasPendingFrame = true;
+	}
+	else if (bReplaying)
+	{
+		if (!bHasNextFrame)
+		{
+			FinishReplay();
+			return;
+		}
+
+		for (const FRecordedInput& Input : NextInputs)
+		{
+			DispatchInput(Input);
+		}
+		++NumReplayedFrames;
+
+		bHasNextFrame = ReadFrame(NextDeltaTime, NextInputs);
+		if (bHasNextFrame)
+		{
+			FApp::SetFixedDeltaTime(NextDeltaTime);
+		}
+	}
+}
+
+void UGameplaySystemsInputRecorder::CommitFrame()
+{
+	using namespace GameplaySystemsInputRecorder;
+
+	FChunk& Chunk = GetWritableChunk();
+
+	WriteDelta(Chunk.Bytes, WriteState.DeltaTimeBits, PendingDeltaTime);
+	WriteVarUInt(Chunk.Bytes, PendingInputs.Num());
+
+	for (const FRecordedInput& Input : PendingInputs)
+	{
+		Chunk.Bytes.Add(static_cast<uint8>(Input.Channel));
+
+		if (IsAxisChannel(Input.Channel))
+		{
+			uint32 (&AxisBits)[2] = WriteState.AxisBits[static_cast<uint8>(Input.Channel)];
+			WriteDelta(Chunk.Bytes, AxisBits[0], Input.Value.X);
+			WriteDelta(Chunk.Bytes, AxisBits[1], Input.Value.Y);
+		}
+	}
+
+	++Chunk.NumFrames;
+	PendingInputs.Reset();
+	bHasPendingFrame = false;
+}
+
+UGameplaySystemsInputRecorder::FChunk& UGameplaySystemsInputRecorder::GetWritableChunk()
+{
+	if (NewestChunk != INDEX_NONE && Chunks[NewestChunk].Bytes.Num() < GameplaySystemsInputRecorder::ChunkSize)
+	{
+		return Chunks[NewestChunk];
+	}
+
+	if (Chunks.Num() < MaxChunks)
+	{
+		NewestChunk = Chunks.AddDefaulted();
+		Chunks[NewestChunk].Bytes.Reserve(GameplaySystemsInputRecorder::ChunkSize + 64);
+	}
+	else
+	{
+		// ring is full, the oldest chunk is recycled along with its allocation
+		NewestChunk = OldestChunk;
+		OldestChunk = (OldestChunk + 1) % Chunks.Num();
+		Chunks[NewestChunk].Bytes.Reset();
+		Chunks[NewestChunk].NumFrames = 0;
+	}
+
+	// every chunk starts from a clean delta state so it can be decoded on its own
+	WriteState.Reset();
+	return Chunks[NewestChunk];
+}
+
+bool UGameplaySystemsInputRecorder::ReadFrame(float& OutDeltaTime, FFrameInputs& OutInputs)
+{
+	using namespace GameplaySystemsInputRecorder;
+
+	OutInputs.Reset();
+
+	while (ReadChunk < Chunks.Num() && ReadFrameInChunk >= Chunks[(OldestChunk + ReadChunk) % Chunks.Num()].NumFrames)
+	{
+		++ReadChunk;
+		ReadOffset = 0;
+		ReadFrameInChunk = 0;
+		ReadState.Reset();
+	}
+
+	if (ReadChunk >= Chunks.Num())
+	{
+		return false;
+	}
+
+	const TArray<uint8>& Bytes = Chunks[(OldestChunk + ReadChunk) % Chunks.Num()].Bytes;
+
+	uint32 NumInputs = 0;
+	if (!ReadDelta(Bytes, ReadOffset, ReadState.DeltaTimeBits, OutDeltaTime) || !ReadVarUInt(Bytes, ReadOffset, NumInputs))
+	{
+		UE_LOG(LogGameplaySystems, Error, TEXT("Input recording is corrupted in chunk %d."), ReadChunk);
+		return false;
+	}
+
+	for (uint32 Index = 0; Index < NumInputs; ++Index)
+	{
+		if (!Bytes.IsValidIndex(ReadOffset))
+		{
+			return false;
+		}
+
+		FRecordedInput& Input = OutInputs.AddDefaulted_GetRef();
+		Input.Channel = static_cast<EGameplaySystemsInputChannel>(Bytes[ReadOffset++]);
+		Input.Value = FVector2f::ZeroVector;
+
+		if (IsAxisChannel(Input.Channel))
+		{
+			uint32 (&AxisBits)[2] = ReadState.AxisBits[static_cast<uint8>(Input.Channel)];
+			if (!ReadDelta(Bytes, ReadOffset, AxisBits[0], Input.Value.X) || !ReadDelta(Bytes, ReadOffset, AxisBits[1], Input.Value.Y))
+			{
+				return false;
+			}
+		}
+	}
+
+	++ReadFrameInChunk;
+	return true;
+}
+
+void UGameplaySystemsInputRecorder::DispatchInput(const FRecordedInput& Input) const
+{
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (AGameplaySystemsCharacter* Character = PlayerController ? Cast<AGameplaySystemsCharacter>(PlayerController->GetPawn()) : nullptr)
+	{
+		Character->ReplayInput(Input.Channel, FVector2D(Input.Value));
+	}
+}
+
+void UGameplaySystemsInputRecorder::FinishReplay()
+{
+	const double WallMs = (FPlatformTime::Seconds() - ReplayStartTime) * 1000.;
+	UE_LOG(LogGameplaySystems, Display, TEXT("Input replay finished: %d frames in %.2f ms, %.3f ms per frame."),
+		NumReplayedFrames, WallMs, WallMs / FMath::Max(1, NumReplayedFrames));
+
+	StopReplay();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("InputReplayExit")))
+	{
+		FPlatformMisc::RequestExit(false, TEXT("UGameplaySystemsInputRecorder::FinishReplay"));
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+static FAutoConsoleCommandWithWorldAndArgs GInputRecordCommand(
+	TEXT("GameplaySystems.Input.Record"),
+	TEXT("Starts recording character input. Usage: GameplaySystems.Input.Record [CapacityKB]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UGameplaySystemsInputRecorder* Recorder = World ? World->GetSubsystem<UGameplaySystemsInputRecorder>() : nullptr)
+		{
+			Recorder->StartRecording(Args.Num() > 0 ? FCString::Atoi(*Args[0]) * 1024 : 4 * 1024 * 1024);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GInputSaveCommand(
+	TEXT("GameplaySystems.Input.Save"),
+	TEXT("Stops recording and saves it. Usage: GameplaySystems.Input.Save <File>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UGameplaySystemsInputRecorder* Recorder = World ? World->GetSubsystem<UGameplaySystemsInputRecorder>() : nullptr)
+		{
+			Recorder->StopRecording();
+			Recorder->SaveRecording(Args.Num() > 0 ? Args[0] : TEXT("Input.gsir"));
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GInputReplayCommand(
+	TEXT("GameplaySystems.Input.Replay"),
+	TEXT("Replays a saved recording with its recorded frame times. Usage: GameplaySystems.Input.Replay <File>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UGameplaySystemsInputRecorder* Recorder = World ? World->GetSubsystem<UGameplaySystemsInputRecorder>() : nullptr)
+		{
+			Recorder->StartReplay(Args.Num() > 0 ? Args[0] : TEXT("Input.gsir"));
+		}
+	}));
+
+#endif
@@ -0,0 +1,124 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GameplaySystemsInputRecorder.generated.h"
+
+/** Character input handlers captured by the recorder */
+UENUM()
+enum class EGameplaySystemsInputChannel : uint8
+{
+	Move,
+	Look,
+	JumpStart,
+	JumpEnd
+};
+
+/**
+ *  Records the character input handlers and the frame delta times into a compact binary ring buffer,
+ *  and replays such a recording with a fixed time step so headless sessions get identical input.
+ *  Values are stored losslessly as zigzag varint deltas of their bit patterns, most frames take a few bytes.
+ */
+UCLASS()
+class UGameplaySystemsInputRecorder : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	//~UWorldSubsystem
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	//~End of UWorldSubsystem
+
+	/** Starts a new recording, the oldest frames are dropped once CapacityBytes is reached */
+	void StartRecording(int32 CapacityBytes = 4 * 1024 * 1024);
+
+	/** Stops recording, the recorded frames stay available for saving */
+	void StopRecording();
+
+	/** Writes the recorded frames to disk */
+	bool SaveRecording(const FString& FilePath) const;
+
+	/** Loads a recording and feeds it to the local player's character from the next frame on */
+	bool StartReplay(const FString& FilePath);
+
+	/** Stops feeding recorded input and restores the time step */
+	void StopReplay();
+
+	bool IsRecording() const { return bRecording; }
+	bool IsReplaying() const { return bReplaying; }
+
+	/** Called by the character input handlers while recording */
+	void RecordInput(EGameplaySystemsInputChannel Channel, const FVector2D& Value = FVector2D::ZeroVector);
+
+protected:
+
+	/** A self contained run of frames, the delta state restarts at the beginning of every chunk */
+	struct FChunk
+	{
+		TArray<uint8> Bytes;
+		int32 NumFrames = 0;
+	};
+
+	/** Bit patterns the next values are delta encoded against */
+	struct FStreamState
+	{
+		uint32 DeltaTimeBits = 0;
+		uint32 AxisBits[2][2] = {};
+
+		void Reset() { *this = FStreamState(); }
+	};
+
+	struct FRecordedInput
+	{
+		EGameplaySystemsInputChannel Channel;
+		FVector2f Value;
+	};
+
+	/** Frame boundary, commits the recorded frame or dispatches the next replayed one */
+	void HandleWorldTickStart(UWorld* TickedWorld, ELevelTick TickType, float DeltaSeconds);
+
+	void CommitFrame();
+	FChunk& GetWritableChunk();
+
+	using FFrameInputs = TArray<FRecordedInput, TInlineAllocator<8>>;
+
+	bool ReadFrame(float& OutDeltaTime, FFrameInputs& OutInputs);
+	void DispatchInput(const FRecordedInput& Input) const;
+	void FinishReplay();
+
+	/** Chunks in ring order starting at OldestChunk */
+	TArray<FChunk> Chunks;
+	int32 OldestChunk = 0;
+	int32 NewestChunk = INDEX_NONE;
+	int32 MaxChunks = 0;
+
+	FStreamState WriteState;
+	FFrameInputs PendingInputs;
+	float PendingDeltaTime = 0.f;
+	bool bHasPendingFrame = false;
+	bool bRecording = false;
+
+	FStreamState ReadState;
+	int32 ReadChunk = 0;
+	int32 ReadOffset = 0;
+	int32 ReadFrameInChunk = 0;
+	bool bReplaying = false;
+
+	/** Replay runs one frame ahead, the next frame's delta time becomes the fixed time step */
+	FFrameInputs NextInputs;
+	float NextDeltaTime = 0.f;
+	bool bHasNextFrame = false;
+
+	int32 NumReplayedFrames = 0;
+	double ReplayStartTime = 0.;
+	bool bSavedUseFixedTimeStep = false;
+	double SavedFixedDeltaTime = 0.;
+
+	FDelegateHandle WorldTickStartHandle;
+};
@@ -7,6 +7,9 @@
 #include "InputMappingContext.h"
 #include "Blueprint/UserWidget.h"
 #include "GameplaySystems.h"
+#include "GameplaySystemsCharacter.h"
+#include "Libs/InputLatencyTracker.h"
+#include "Subsystems/InputMappingContextRegistry.h"
 #include "Widgets/Input/SVirtualJoystick.h"
 
 void AGameplaySystemsPlayerController::BeginPlay()
@@ -33,19 +36,46 @@ void AGameplaySystemsPlayerController::BeginPlay()
 	}
 }
 
+void AGameplaySystemsPlayerController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// only drop this controller's references, a feature holding the same context keeps it applied
+	if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer()))
+	{
+		FInputMappingContextBatch MappingBatch;
+		UInputMappingContextRegistry::BeginMappingContextBatch(MappingBatch);
+		for (UInputMappingContext* CurrentContext : RegisteredMappingContexts)
+		{
+			UInputMappingContextRegistry::BatchRemoveMappingContext(MappingBatch, Subsystem, CurrentContext, 0);
+		}
+		UInputMappingContextRegistry::CommitMappingContextBatch(MappingBatch);
+	}
+	RegisteredMappingContexts.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AGameplaySystemsPlayerController::SetupInputComponent()
 {
 	Super::SetupInputComponent();
 
 	// only add IMCs for local player controllers
-	if (IsLocalPlayerController())
+	if (IsLocalPlayerController() && RegisteredMappingContexts.IsEmpty())
 	{
 		// Add Input Mapping Contexts
 		if (UEnhancedInputLocalPlayerSubsystem* Subsystem = ULocalPlayer::GetSubsystem<UEnhancedInputLocalPlayerSubsystem>(GetLocalPlayer()))
 		{
+			// referenced through the registry like the features' contexts, so a feature releasing a shared one never strips it
+			// and the whole set costs a single control mapping rebuild
+			FInputMappingContextBatch MappingBatch;
+			UInputMappingContextRegistry::BeginMappingContextBatch(MappingBatch);
+
 			for (UInputMappingContext* CurrentContext : DefaultMappingContexts)
 			{
-				Subsystem->AddMappingContext(CurrentContext, 0);
+				if (CurrentContext)
+				{
+					UInputMappingContextRegistry::BatchAddMappingContext(MappingBatch, Subsystem, CurrentContext, 0);
+					RegisteredMappingContexts.Add(CurrentContext);
+				}
 			}
 
 			// only add these IMCs if we're not using mobile touch input
@@ -53,9 +83,39 @@ void AGameplaySystemsPlayerController::SetupInputComponent()
 			{
 				for (UInputMappingContext* CurrentContext : MobileExcludedMappingContexts)
 				{
-					Subsystem->AddMappingContext(CurrentContext, 0);
+					if (CurrentContext)
+					{
+						UInputMappingContextRegistry::BatchAddMappingContext(MappingBatch, Subsystem, CurrentContext, 0);
+						RegisteredMappingContexts.Add(CurrentContext);
+					}
 				}
 			}
+
+			UInputMappingContextRegistry::CommitMappingContextBatch(MappingBatch);
+		}
+	}
+}
+
+void AGameplaySystemsPlayerController::PreProcessInput(const float DeltaTime, const bool bGamePaused)
+{
+	Super::PreProcessInput(DeltaTime, bGamePaused);
+
+	if (FInputLatencyTracker::IsEnabled())
+	{
+		FInputLatencyTracker::Get().MarkInputProcessing();
+	}
+}
+
+void AGameplaySystemsPlayerController::PostProcessInput(const float DeltaTime, const bool bGamePaused)
+{
+	Super::PostProcessInput(DeltaTime, bGamePaused);
+
+	// input is fully processed for this frame, the rotation update and movement come after this
+	if (AGameplaySystemsCharacter* GameplayCharacter = Cast<AGameplaySystemsCharacter>(GetPawn()))
+	{
+		if (GameplayCharacter->GetInputAggregation() == EGameplaySystemsInputAggregation::LatencyPreserving)
+		{
+			GameplayCharacter->FlushAggregatedInput();
 		}
 	}
 }
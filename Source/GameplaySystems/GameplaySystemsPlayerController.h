@@ -36,6 +36,10 @@ protected:
 	UPROPERTY()
 	TObjectPtr<UUserWidget> MobileControlsWidget;
 
+	/** Mapping contexts this controller holds a registry reference to, released on EndPlay */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UInputMappingContext>> RegisteredMappingContexts;
+
 	/** If true, the player will use UMG touch controls even if not playing on mobile platforms */
 	UPROPERTY(EditAnywhere, Config, Category = "Input|Touch Controls")
 	bool bForceTouchControls = false;
@@ -43,9 +47,18 @@ protected:
 	/** Gameplay initialization */
 	virtual void BeginPlay() override;
 
+	/** Releases the default mapping contexts */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	/** Input mapping context setup */
 	virtual void SetupInputComponent() override;
 
+	/** Stamps the start of input processing for the input latency tracker */
+	virtual void PreProcessInput(const float DeltaTime, const bool bGamePaused) override;
+
+	/** Applies the pawn's aggregated input in the same frame it was received */
+	virtual void PostProcessInput(const float DeltaTime, const bool bGamePaused) override;
+
 	/** Returns true if the player should use UMG touch controls */
 	bool ShouldUseTouchControls() const;
 